@@ -2,147 +2,39 @@
 #include "tools/simd.h"
 #include "tools/stats.h"
 #include "tools/matrix.h"
+#include "pure/gemm.h"
+#include "matmul.h"
 
-using vf32 = vf32t<8>;
-[[assume(vf32::size() % 2u == 0u)]];
+#include <string_view>
 
-f32 * alloc(std::size_t const n) noexcept
+// Sweeps matmul's ProcessElemNo, the pure/ gemm profile and the Strassen cutoff, writes the winner
+int autotune()
 {
-    f32 * ptr = (f32*) std::aligned_alloc(64u, 4u * n);
-    memset(ptr, 0u, 4u * n); 
-    return ptr;
-}
-
-
-template
-<
-    std::size_t RegPackSize,
-    std::size_t RegSize
->   [[using gnu : hot]]
-void kernel( f32  const * const a
-           , vf32 const * const b
-           , vf32       * const c
-           , std::size_t const ii
-           , std::size_t const jj
-           , std::size_t const le
-           , std::size_t const ri
-           , std::size_t const N
-           ) noexcept
-{
-    [[assume(a != nullptr)]];
-    [[assume(b != nullptr)]];
-    [[assume(c != nullptr)]];
-    [[assume(N > 0u)]];
-
-    // Process N elements at once
-    // Use 2^K-float regs then:
-    //
-    //      N / 2^K = M x 2,
-    //
-    // M - rows No of registers tile. E.g.:
-    //
-    //             Tile (pack)
-    //
-    // [][][][][][][][] | [][][][][][][][]
-    // -----------------|-----------------
-    // [][][][][][][][] | [][][][][][][][]
-    // -----------------|-----------------
-    // [][][][][][][][] | [][][][][][][][]
-    // -----------------|-----------------
-    // [][][][][][][][] | [][][][][][][][]
-    //                .....
-    // [][][][][][][][] | [][][][][][][][]
-    //
-    
-    vf32 pack[RegPackSize][2u] = {0.f};
-
-    for(std::size_t k = le; k < ri         ; ++k)
-    for(std::size_t i = 0u; i < RegPackSize; ++i)
-    {
-        vf32 const ak = a[(ii + i) * N + k];
-
-        for(std::size_t j = 0u; j < 2u; ++j)
-            pack[i][j] += ak * b[(N * k + jj) / RegSize + j];
-    }
-
-    for(std::size_t i = 0u; i < RegPackSize; ++i)
-    for(std::size_t j = 0u; j < 2u         ; ++j)
-        c[((ii + i) * N  + jj) / RegSize + j] += pack[i][j];
-}
-
-constexpr std::size_t reserve = 1920u * 1920u; // ~16 MB
+    std::size_t const n = 1024u;
+    std::vector<f32> A(n * n, 1.f), B(n * n, 1.f), C(n * n);
 
-template
-<
-    std::size_t ProcessElemNo,
-    std::size_t RegSize = vf32::size()
->   [[using gnu : hot]]
-void matmul( f32 const * const A
-           , f32 const * const B
-           , f32       * const C
-           , std::size_t const N
-           ) noexcept
-{
-    [[assume(A != nullptr)]];
-    [[assume(B != nullptr)]];
-    [[assume(C != nullptr)]];
-    [[assume(N > 0u)]];
-
-    constexpr std::size_t Reg2Size    = RegSize * 2u;
-    constexpr std::size_t RegPackSize = ProcessElemNo / Reg2Size;
-
-    std::size_t const Nx = (N + RegPackSize - 1u) / RegPackSize * RegPackSize;
-    std::size_t const Ny = (N + Reg2Size    - 1u) / Reg2Size    * Reg2Size;
-
-    alignas(64u) static f32 a[reserve]
-                          , b[reserve]
-                          , c[reserve];
-    
-    std::memset(c, 0u, sizeof(int) * Nx * Ny);
-
-    for(std::size_t i = 0u; i < N; ++i)
-    {
-        std::memcpy(&a[i * Ny], &A[i * N], 4u * N);
-        std::memcpy(&b[i * Ny], &B[i * N], 4u * N);
-    }
-
-    std::size_t const u = ProcessElemNo;
-    std::size_t const s3 = u;            // Cols No of B
-    std::size_t const s2 = 2u * u;       // Rows No of A
-    std::size_t const s1 = 4u * u;       // Rows No of B
-
-    ThreadPool pool(std::thread::hardware_concurrency());
+    profile_t p = autotune(std::thread::hardware_concurrency(), std::cout);
+    p.strassen  = autotune_strassen(std::thread::hardware_concurrency(), std::cout);
 
-    for(std::size_t i3 = 0u; i3 < Ny; i3 += s3)
-    for(std::size_t i2 = 0u; i2 < Nx; i2 += s2)
-    for(std::size_t i1 = 0u; i1 < Ny; i1 += s1)
-        pool.enqueue([=] noexcept
+    double best = INFINITY;
+    for(std::size_t const candidate : {48u, 96u, 192u})
+        withProcessElemNo(candidate, [&](auto const P) noexcept
         {
-            for(std::size_t ii = i2; ii < std::min(Nx, i2 + s2); ii += RegPackSize)
-            for(std::size_t jj = i3; jj < std::min(Ny, i3 + s3); jj += Reg2Size   )
-                kernel<RegPackSize, RegSize>
-                (
-                    a, 
-                    reinterpret_cast<vf32 const * const>(b), 
-                    reinterpret_cast<vf32       * const>(c), 
-                    
-                    ii, 
-                    jj, 
-                    i1, 
-                    std::min(i1 + s1, N), 
-                    Ny
-                );
-
-            for(std::size_t i = 0u; i < N; ++i)
-                std::memcpy
-                (
-                    &C[i * N ], 
-                    &c[i * Ny], 
-                      4u * N
-                );
+            auto const [E, D] = utils::stats<4u>([&] noexcept
+            {
+                matmul<P()>(A.data(), B.data(), C.data(), n);
+            });
+            std::cout << "# matmul<" << P() << "u>: " << 1000. * E << " ms" << std::endl;
+
+            if(E < best)
+            {
+                best = E;
+                p.ProcessElemNo = P();
+            }
         });
-        
-    pool.wait();
+
+    std::cout << "# profile: " << p << " -> " << profile_path() << std::endl;
+    return save_profile(p, profile_path()) ? 0 : 1;
 }
 
 void printMatrix( f32 const * const m
@@ -174,8 +66,11 @@ f32 * emptyMatrix( std::size_t const M
     return res;
 }
 
-int main()
+int main(int argc, char ** argv)
 {
+    if(argc > 1 && std::string_view(argv[1]) == "autotune")
+        return autotune();
+
     for(std::size_t n = 16u; n <= 1920u; n += 17u)
     {
         f32 * A = emptyMatrix(n, n, 64);
@@ -194,7 +89,7 @@ int main()
 
         auto const [E, D] = utils::stats<4u>([&] noexcept
         {
-            matmul<96u>(A, B, C, n);
+            matmulTuned(A, B, C, n);
         });
    
         //printMatrix(C, M, N);
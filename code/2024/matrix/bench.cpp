@@ -0,0 +1,297 @@
+#include "tools/threadpool.h"
+#include "tools/stats.h"
+#include "tools/matrix.h"
+#include "pure/gemm.h"
+#include "mod/mult.h"
+#include "mult/reordered.h"
+#include "matmul.h"
+
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <cmath>
+
+// Every implementation on square and rectangular shapes at 1, 2, 4, ... threads up to the machine's:
+// GFLOPS, percent of the machine's peak and of the peak of the cores used, parallel efficiency
+// against the same run on one thread. CSV by default, `bench json` for JSON, `bench csv 8` caps the threads.
+// The peak is measured: independent FMA chains on the kernel's ISA, times the physical cores
+// (SMT siblings share the FMA units); the scalar kernel has none, its peak columns are left empty.
+// "sgemm B packed ahead" and "sgemm B packed in phase" are the pooled sgemm with and without the next
+// B panel packed during the compute of the current one: its fraction of peak after and before
+
+// GFLOPS of one core on FMA chains that do not wait on each other
+AVX512 double core_peak_avx512()
+{
+    __m512 acc[16];
+    for(int r = 0; r < 16; ++r)
+        acc[r] = _mm512_set1_ps(float(r));
+    __m512 const a = _mm512_set1_ps(.999f), b = _mm512_set1_ps(.001f);
+
+    long const n = 5'000'000;
+    auto const E = utils::measureExecutionTime<1u>([&] noexcept
+    {
+        for(long i = 0; i < n; ++i)
+            for(int r = 0; r < 16; ++r)
+                acc[r] = _mm512_fmadd_ps(acc[r], a, b);
+    });
+
+    alignas(64) float s[16];
+    volatile float sink = 0.f;
+    for(int r = 0; r < 16; ++r)
+    {
+        _mm512_store_ps(s, acc[r]);
+        sink = sink + s[0];
+    }
+    return 1e-9 * 2. * 16. * 16. * double(n) / E;
+}
+
+AVX2 double core_peak_avx2()
+{
+    __m256 acc[12];
+    for(int r = 0; r < 12; ++r)
+        acc[r] = _mm256_set1_ps(float(r));
+    __m256 const a = _mm256_set1_ps(.999f), b = _mm256_set1_ps(.001f);
+
+    long const n = 5'000'000;
+    auto const E = utils::measureExecutionTime<1u>([&] noexcept
+    {
+        for(long i = 0; i < n; ++i)
+            for(int r = 0; r < 12; ++r)
+                acc[r] = _mm256_fmadd_ps(acc[r], a, b);
+    });
+
+    alignas(32) float s[8];
+    volatile float sink = 0.f;
+    for(int r = 0; r < 12; ++r)
+    {
+        _mm256_store_ps(s, acc[r]);
+        sink = sink + s[0];
+    }
+    return 1e-9 * 2. * 8. * 12. * double(n) / E;
+}
+
+// the best of a few runs, a shared or throttled core only ever shows less; 0 if not measured
+double core_peak()
+{
+    std::string_view const name = kernel().name;
+    double best = 0.;
+    for(int run = 0; run < 5 && (name == "avx512" || name == "avx2"); ++run)
+        best = std::max(best, name == "avx512" ? core_peak_avx512() : core_peak_avx2());
+    return best;
+}
+
+// NaN, for an unknown peak, as an empty CSV field or a JSON null
+struct field_t
+{
+    double x;
+    char const * none;
+};
+
+std::ostream & operator<<(std::ostream & os, field_t const f)
+{
+    return std::isnan(f.x) ? os << f.none : os << f.x;
+}
+
+struct shape_t
+{
+    int M, N, K;
+};
+
+struct result_t
+{
+    char const * impl;
+    shape_t shape;
+    unsigned int threads;
+    double ms, stddev, gflops, peak, cores, efficiency;
+};
+
+int main(int argc, char ** argv)
+{
+    bool const json = argc > 1 && std::string_view(argv[1]) == "json";
+    unsigned int const hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned int const maxThreads = argc > 2 ? std::clamp(unsigned(std::atoi(argv[2])), 1u, hw) : hw;
+
+    // logical cpus over the ones sharing an L1: the SMT siblings of a core
+    unsigned int const cores = std::max(1u, hw / unsigned(std::max(1, caches().L1.shared)));
+    double const core = core_peak(), machine = core * cores;
+
+    std::vector<unsigned int> threads;
+    for(unsigned int t = 1u; t < maxThreads; t *= 2u)
+        threads.push_back(t);
+    threads.push_back(maxThreads);
+
+    // made once, outside of the timed runs; none for one thread
+    std::vector<std::unique_ptr<ThreadPool>> pools;
+    for(unsigned int const t : threads)
+        pools.push_back(t > 1u ? std::make_unique<ThreadPool>(t) : nullptr);
+
+    std::vector<shape_t> const shapes =
+    {
+        { 256, 256, 256 }, { 512, 512, 512 }, { 1024, 1024, 1024 }, { 1536, 1536, 1536 }, { 1920, 1920, 1920 },
+        { 2048, 2048, 256 }, { 256, 2048, 2048 }, { 2048, 256, 2048 }, { 4096, 512, 1024 }, { 64, 4096, 4096 },
+    };
+
+    // A and B of a shape, in f64 as well for the dgemm
+    struct operands_t
+    {
+        Matrix<float>  A, B;
+        Matrix<double> Ad, Bd;
+    };
+
+    // impl(M, N, K, operands, C, pool), pool == nullptr for one thread; square: square shapes only; serial: one thread only
+    struct impl_t
+    {
+        char const * name;
+        bool square, serial;
+        double maxFlop;
+        std::function<void(shape_t, operands_t const &, Matrix<float> &, ThreadPool *)> run;
+    };
+    // the sgemm on its own workspace, bufB with room for `panels` B panels: with two the pool packs the next one
+    // during the compute of the current one, with one in a phase of its own, a second barrier per block
+    auto const workspace = [](shape_t s, operands_t const & o, Matrix<float> & C, ThreadPool * pool, int panels)
+    {
+        blocking_t const blocking = make_blocking(s.M, s.N, s.K, pool ? pool->size() : 1u);
+        buf_t bufB(panels * bufB_size(blocking));
+        std::vector<buf_t> bufA;
+        for(int t = 0; t < (pool ? blocking.tM * blocking.tN : 1); ++t)
+            bufA.emplace_back(bufA_size(blocking));
+
+        if(!pool)
+            return sgemm('N', 'N', s.M, s.N, s.K, 1.f, o.A.memory.get(), s.K, o.B.memory.get(), s.N, 0.f, C.memory.get(), s.N, blocking, bufB, bufA[0]);
+        sgemm('N', 'N', s.M, s.N, s.K, 1.f, o.A.memory.get(), s.K, o.B.memory.get(), s.N, 0.f, C.memory.get(), s.N, blocking, bufB, bufA, *pool);
+    };
+
+    std::vector<impl_t> const impls =
+    {
+        {
+            "matmul", true, false, INFINITY,
+            [](shape_t s, operands_t const & o, Matrix<float> & C, ThreadPool * pool)
+            {
+                if(!pool)
+                    return matmulTuned(o.A.memory.get(), o.B.memory.get(), C.memory.get(), s.M, 1u);
+                matmulTuned(o.A.memory.get(), o.B.memory.get(), C.memory.get(), s.M, *pool);
+            }
+        },
+        {
+            "gemm", false, false, INFINITY,
+            [](shape_t s, operands_t const & o, Matrix<float> & C, ThreadPool * pool)
+            {
+                if(!pool)
+                    return gemm(s.M, s.N, s.K, o.A.memory.get(), o.B.memory.get(), C.memory.get());
+                gemm(s.M, s.N, s.K, o.A.memory.get(), o.B.memory.get(), C.memory.get(), *pool);
+            }
+        },
+        {
+            "sgemm B packed ahead", false, false, INFINITY,
+            [workspace](shape_t s, operands_t const & o, Matrix<float> & C, ThreadPool * pool)
+            {
+                workspace(s, o, C, pool, 2);
+            }
+        },
+        {
+            "sgemm B packed in phase", false, false, INFINITY,
+            [workspace](shape_t s, operands_t const & o, Matrix<float> & C, ThreadPool * pool)
+            {
+                workspace(s, o, C, pool, 1);
+            }
+        },
+        {
+            "multiply", false, true, INFINITY,
+            [](shape_t, operands_t const & o, Matrix<float> & C, ThreadPool *)
+            {
+                C = multiply<f32>(o.A, o.B);
+            }
+        },
+        {
+            "multiply<f64>", false, true, INFINITY,
+            [](shape_t s, operands_t const & o, Matrix<float> & C, ThreadPool *)
+            {
+                Matrix<double> const D = multiply<f64>(o.Ad, o.Bd);
+                C[0][0] = float(D[0][0]), C[s.M - 1][s.N - 1] = float(D[s.M - 1][s.N - 1]); // what the check reads
+            }
+        },
+        {
+            "multiply<f32,f64>", false, true, INFINITY,
+            [](shape_t, operands_t const & o, Matrix<float> & C, ThreadPool *)
+            {
+                C = multiply<f32, f64>(o.A, o.B);
+            }
+        },
+        {
+            "multiplyReordered", false, true, 2. * 512. * 512. * 512.,
+            [](shape_t, operands_t const & o, Matrix<float> & C, ThreadPool *)
+            {
+                C = multiplyReordered(o.A, o.B);
+            }
+        },
+    };
+
+    std::vector<result_t> results;
+    for(shape_t const s : shapes)
+    {
+        double const flop = 2. * s.M * s.N * s.K;
+
+        // contiguous, memoryWidth == width: gemm and matmul take them as plain arrays
+        operands_t o = { emptyMatrix<float>(s.K, s.M, 64), emptyMatrix<float>(s.N, s.K, 64), emptyMatrix<double>(s.K, s.M, 64), emptyMatrix<double>(s.N, s.K, 64) };
+        assert(o.A.memoryWidth == o.A.width && o.B.memoryWidth == o.B.width && o.Ad.memoryWidth == o.Ad.width && o.Bd.memoryWidth == o.Bd.width);
+        for(int i = 0; i < s.M * s.K; ++i) o.A.memory[i] = 1.f, o.Ad.memory[i] = 1.;
+        for(int i = 0; i < s.K * s.N; ++i) o.B.memory[i] = 1.f, o.Bd.memory[i] = 1.;
+
+        for(impl_t const & impl : impls)
+        {
+            if((impl.square && (s.M != s.N || s.N != s.K)) || flop > impl.maxFlop)
+                continue;
+
+            double one = 0.;
+            for(std::size_t p = 0; p < threads.size(); ++p)
+            {
+                unsigned int const t = threads[p];
+                ThreadPool * const pool = pools[p].get();
+                if(impl.serial && t > 1u)
+                    break;
+
+                Matrix<float> C = emptyMatrix<float>(s.N, s.M, 64);
+                impl.run(s, o, C, pool); // warm-up, and every element is K
+                if(C[0][0] != float(s.K) || C[s.M - 1][s.N - 1] != float(s.K))
+                    std::cerr << "# " << impl.name << " " << s.M << "x" << s.N << "x" << s.K << ": wrong result" << std::endl;
+
+                auto const [E, D] = utils::stats<3u>([&] noexcept
+                {
+                    impl.run(s, o, C, pool);
+                });
+
+                double const gflops = 1e-9 * flop / E;
+                if(t == 1u)
+                    one = gflops;
+                double const used = core * std::min(t, cores); // SMT threads beyond the cores add no FMA units
+                results.push_back({ impl.name, s, t, 1000. * E, 1000. * std::sqrt(D), gflops, core > 0. ? 100. * gflops / machine : NAN, core > 0. ? 100. * gflops / used : NAN, gflops / (one * t) });
+            }
+        }
+    }
+
+    if(json)
+    {
+        std::cout << "{\n  \"kernel\": \"" << kernel().name << "\", \"hardware_threads\": " << hw << ", \"cores\": " << cores
+                  << ", \"core_peak_gflops\": " << field_t{ core > 0. ? core : NAN, "null" } << ", \"machine_peak_gflops\": " << field_t{ core > 0. ? machine : NAN, "null" } << ",\n  \"results\": [\n";
+        for(std::size_t i = 0; i < results.size(); ++i)
+        {
+            result_t const & r = results[i];
+            std::cout << "    { \"impl\": \"" << r.impl << "\", \"M\": " << r.shape.M << ", \"N\": " << r.shape.N << ", \"K\": " << r.shape.K
+                      << ", \"threads\": " << r.threads << ", \"ms\": " << r.ms << ", \"ms_stddev\": " << r.stddev
+                      << ", \"gflops\": " << r.gflops << ", \"peak_pct\": " << field_t{ r.peak, "null" } << ", \"cores_peak_pct\": " << field_t{ r.cores, "null" }
+                      << ", \"efficiency\": " << r.efficiency << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "  ]\n}" << std::endl;
+    }
+    else
+    {
+        std::cout << "# kernel " << kernel().name << ", " << hw << " hardware threads on " << cores << " cores, peak GFLOPS: core " << field_t{ core > 0. ? core : NAN, "-" } << ", machine " << field_t{ core > 0. ? machine : NAN, "-" } << "\n";
+        std::cout << "impl,M,N,K,threads,ms,ms_stddev,gflops,peak_pct,cores_peak_pct,efficiency\n";
+        for(result_t const & r : results)
+            std::cout << r.impl << "," << r.shape.M << "," << r.shape.N << "," << r.shape.K << "," << r.threads << "," << r.ms << "," << r.stddev
+                      << "," << r.gflops << "," << field_t{ r.peak, "" } << "," << field_t{ r.cores, "" } << "," << r.efficiency << "\n";
+        std::cout << std::flush;
+    }
+    return 0;
+}
@@ -0,0 +1,628 @@
+#include "tools/stats.h"
+#include "pure/gemm.h"
+#include "mult/reordered.h"
+
+#include <string_view>
+#include <thread>
+#include <cmath>
+#include <cstring>
+
+// Strassen–Winograd against the blocked sgemm: time, and max error of both against multiplyReordered
+int strassen()
+{
+    std::cout << "# strassen cutoff: " << strassen_cutoff() << std::endl;
+
+    for(int n = 1024; n <= 4096; n *= 2)
+    {
+        Matrix<float> A = emptyMatrix<float>(n, n), B = emptyMatrix<float>(n, n);
+        for(int i = 0; i < n; ++i)
+        for(int j = 0; j < n; ++j)
+        {
+            A[i][j] = float((i * 7 + j * 3) % 17) / 17.f - .5f;
+            B[i][j] = float((i * 5 + j * 11) % 13) / 13.f - .5f;
+        }
+        Matrix<float> const R = multiplyReordered(A, B);
+        Matrix<float> C = emptyMatrix<float>(n, n), S = emptyMatrix<float>(n, n);
+
+        int const cutoff = std::min(strassen_cutoff(), n); // at least one level
+
+        auto const [Eg, Dg] = utils::stats<3u>([&] noexcept
+        {
+            sgemm('N', 'N', 1.f, A, B, 0.f, C);
+        });
+        auto const [Es, Ds] = utils::stats<3u>([&] noexcept
+        {
+            sgemm_strassen(n, n, n, A.memory.get(), A.memoryWidth, B.memory.get(), B.memoryWidth, S.memory.get(), S.memoryWidth, nullptr, cutoff);
+        });
+
+        double eg = 0., es = 0.;
+        for(int i = 0; i < n; ++i)
+        for(int j = 0; j < n; ++j)
+        {
+            eg = std::max(eg, double(std::abs(C[i][j] - R[i][j])));
+            es = std::max(es, double(std::abs(S[i][j] - R[i][j])));
+        }
+
+        // n, ms: sgemm, strassen; max |error| vs multiplyReordered: sgemm, strassen
+        std::cout << n << " " << 1000. * Eg << " " << 1000. * Es << " " << eg << " " << es << std::endl;
+    }
+    return 0;
+}
+
+// CSR and blocked CSR against densify + sgemm, n x n times n x n, across densities of A;
+// random non-zeros, then the same pattern in each group of 4 rows (what blocked CSR is for)
+int spmm()
+{
+    int const n = 2048;
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+
+    buf_t B(n * n), C(n * n), D(n * n), S(n * n);
+    for(int i = 0; i < n * n; ++i)
+        B.p[i] = float((i * 5) % 13) / 13.f - .5f;
+
+    for(int const group : { 1, bcsr_t::R })
+    for(double density : { .001, .005, .01, .02, .05, .1, .2 })
+    {
+        std::vector<float> A(std::size_t(n) * n, 0.f);
+        std::size_t const step = std::max<std::size_t>(1, std::size_t(1. / density)); // about density * n * n non-zeros
+        for(std::size_t i = 0, h = 12345; i < A.size() / group; i += 1 + h % (2 * step - 1))
+        {
+            h = h * 6364136223846793005ull + 1442695040888963407ull;
+            for(int r = 0; r < group; ++r) // position i of the (n / group) x n pattern, in each row of the group
+                A[(i / n * group + r) * n + i % n] = float(h >> (40 - r) & 0xFF) / 255.f - .5f;
+        }
+        csr_t  const csr  = make_csr(n, n, A.data(), n);
+        bcsr_t const bcsr = make_bcsr(csr);
+
+        auto const [Eg, Dg] = utils::stats<3u>([&] noexcept
+        {
+            densify(csr, D.p, n);
+            sgemm('N', 'N', n, n, n, 1.f, D.p, n, B.p, n, 0.f, C.p, n, pool);
+        });
+        auto const [Ec, Dc] = utils::stats<3u>([&] noexcept
+        {
+            spmm('N', n, 1.f, csr, B.p, n, 0.f, S.p, n, &pool);
+        });
+        auto const [Eb, Db] = utils::stats<3u>([&] noexcept
+        {
+            spmm('N', n, 1.f, bcsr, B.p, n, 0.f, S.p, n, &pool);
+        });
+
+        double e = 0.;
+        for(int i = 0; i < n * n; ++i)
+            e = std::max(e, double(std::abs(S.p[i] - C.p[i])));
+
+        // rows per pattern, % non-zeros, ms: densify + sgemm, csr, bcsr; blocks fill of bcsr, max |bcsr - sgemm|
+        std::cout << group << " " << 100. * csr.val.size() / (double(n) * n) << " " << 1000. * Eg << " " << 1000. * Ec << " " << 1000. * Eb
+                  << " " << double(csr.val.size()) / bcsr.val.size() << " " << e << std::endl;
+    }
+    return 0;
+}
+
+// implicit GEMM against an explicit im2col + sgemm, NHWC and NCHW, on a few 3 x 3 and 1 x 1 layers
+int conv()
+{
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+
+    for(conv_t const cv : { conv_t{ 64, 56, 56, 64, 3, 3, 1, 1 }, conv_t{ 128, 28, 28, 128, 3, 3, 1, 1 }
+                          , conv_t{ 256, 14, 14, 256, 3, 3, 1, 1 }, conv_t{ 256, 56, 56, 64, 1, 1, 1, 0 } })
+    {
+        int const M = cv.P() * cv.Q(), N = cv.K, K = cv.R * cv.S * cv.C;
+
+        buf_t x(cv.H * cv.W * cv.C), w(K * N), y(M * N), z(M * N), col(long(M) * K); // NHWC and NCHW alike
+        for(int i = 0; i < x.n; ++i) x.p[i] = float(i % 13) / 13.f - .5f;
+        for(int i = 0; i < w.n; ++i) w.p[i] = float(i % 7) / 7.f - .5f;
+
+        auto const [Ee, De] = utils::stats<3u>([&] noexcept
+        {
+            for(int m = 0; m < M; ++m)
+                detail::gather_nhwc(cv, x.p, m, 0, K, col.p + long(m) * K);
+            sgemm('N', 'N', M, N, K, 1.f, col.p, K, w.p, N, 0.f, z.p, N, pool);
+        });
+        auto const [Ei, Di] = utils::stats<3u>([&] noexcept
+        {
+            sconv_nhwc(1, cv, x.p, w.p, y.p, &pool);
+        });
+
+        double e = 0.;
+        for(int i = 0; i < M * N; ++i)
+            e = std::max(e, double(std::abs(y.p[i] - z.p[i])));
+
+        // NCHW: y (K x PQ) = w (K x CRS) * im2col^T (CRS x PQ)
+        auto const [Ee2, De2] = utils::stats<3u>([&] noexcept
+        {
+            detail::gather_nchw(cv, x.p, 0, K, 0, M, col.p, M);
+            sgemm('N', 'N', N, M, K, 1.f, w.p, K, col.p, M, 0.f, z.p, M, pool);
+        });
+        auto const [Ei2, Di2] = utils::stats<3u>([&] noexcept
+        {
+            sconv_nchw(1, cv, x.p, w.p, y.p, &pool);
+        });
+
+        double e2 = 0.;
+        for(int i = 0; i < M * N; ++i)
+            e2 = std::max(e2, double(std::abs(y.p[i] - z.p[i])));
+
+        // C H W K R S, ms: NHWC im2col + sgemm, implicit, NCHW im2col + sgemm, implicit;
+        // MB of the im2col buffer, max |implicit - explicit|: NHWC, NCHW
+        std::cout << cv.C << " " << cv.H << " " << cv.W << " " << cv.K << " " << cv.R << " " << cv.S
+                  << " " << 1000. * Ee << " " << 1000. * Ei << " " << 1000. * Ee2 << " " << 1000. * Ei2
+                  << " " << 4e-6 * M * K << " " << e << " " << e2 << std::endl;
+    }
+    return 0;
+}
+
+// 3M cgemm against the 4M product by hand: split into real planes, four sgemm, interleave again
+int cgemm()
+{
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+
+    for(int n = 512; n <= 2048; n *= 2)
+    {
+        std::vector<cfloat> A(n * n), B(n * n), C(n * n), D(n * n);
+        for(int i = 0; i < n * n; ++i)
+        {
+            A[i] = { float(i % 7) / 7.f - .5f, float(i % 5) / 5.f - .5f };
+            B[i] = { float(i % 3) / 3.f - .5f, float(i % 11) / 11.f - .5f };
+        }
+        buf_t ar(n * n), ai(n * n), br(n * n), bi(n * n), cr(n * n), ci(n * n);
+
+        auto const [E3, D3] = utils::stats<3u>([&] noexcept
+        {
+            cgemm('N', 'N', n, n, n, 1.f, A.data(), n, B.data(), n, 0.f, C.data(), n, &pool);
+        });
+        auto const [E4, D4] = utils::stats<3u>([&] noexcept
+        {
+            for(int i = 0; i < n * n; ++i)
+            {
+                ar.p[i] = A[i].real(); ai.p[i] = A[i].imag();
+                br.p[i] = B[i].real(); bi.p[i] = B[i].imag();
+            }
+            sgemm('N', 'N', n, n, n,  1.f, ar.p, n, br.p, n, 0.f, cr.p, n, pool);
+            sgemm('N', 'N', n, n, n, -1.f, ai.p, n, bi.p, n, 1.f, cr.p, n, pool);
+            sgemm('N', 'N', n, n, n,  1.f, ar.p, n, bi.p, n, 0.f, ci.p, n, pool);
+            sgemm('N', 'N', n, n, n,  1.f, ai.p, n, br.p, n, 1.f, ci.p, n, pool);
+            for(int i = 0; i < n * n; ++i)
+                D[i] = { cr.p[i], ci.p[i] };
+        });
+
+        double e = 0.;
+        for(int i = 0; i < n * n; ++i)
+            e = std::max(e, double(std::abs(C[i] - D[i])));
+
+        // n, ms: 3M, 4M; max |3M - 4M|
+        std::cout << n << " " << 1000. * E3 << " " << 1000. * E4 << " " << e << std::endl;
+    }
+    return 0;
+}
+
+// recursive SIMD transpose, out of place and in place, against the naive double loop and a memcpy of the same bytes
+int transpose()
+{
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+
+    for(int const n : { 2000, 4000, 4096, 8192 }) // 4096 and 8192: rows a power of two apart share cache sets
+    {
+        buf_t A(n * n), B(n * n);
+        for(int i = 0; i < n * n; ++i)
+            A.p[i] = float(i);
+
+        auto const [En, Dn] = utils::stats<3u>([&] noexcept
+        {
+            for(int i = 0; i < n; ++i)
+            for(int j = 0; j < n; ++j)
+                B.p[long(j) * n + i] = A.p[long(i) * n + j];
+        });
+        auto const [Eo, Do] = utils::stats<3u>([&] noexcept
+        {
+            transpose(n, n, A.p, n, B.p, n, &pool);
+        });
+        auto const [Ei, Di] = utils::stats<3u>([&] noexcept
+        {
+            transpose_inplace(n, A.p, n, &pool);
+        });
+        auto const [Em, Dm] = utils::stats<3u>([&] noexcept
+        {
+            std::memcpy(B.p, A.p, sizeof(float) * n * n);
+        });
+
+        // n, ms: naive, out of place, in place, memcpy; GB/s moved out of place
+        std::cout << n << " " << 1000. * En << " " << 1000. * Eo << " " << 1000. * Ei << " " << 1000. * Em
+                  << " " << 1e-9 * 2. * sizeof(float) * n * n / Eo << std::endl;
+    }
+    return 0;
+}
+
+// D = A * B + C as an expression, one sgemm over a moved or in-place C, against a product into a
+// fresh matrix and a sum into another, as multiply and multiplyReordered leave it to be written
+int expressions()
+{
+    for(int n = 256; n <= 2048; n *= 2)
+    {
+        Matrix<float> A = emptyMatrix<float>(n, n, 64), B = emptyMatrix<float>(n, n, 64), C = emptyMatrix<float>(n, n, 64);
+        for(int i = 0; i < n; ++i)
+        for(int j = 0; j < n; ++j)
+        {
+            A[i][j] = float((i * 7 + j * 3) % 17) / 17.f - .5f;
+            B[i][j] = float((i * 5 + j * 11) % 13) / 13.f - .5f;
+            C[i][j] = float((i + j) % 7) / 7.f - .5f;
+        }
+        Matrix<float> D = emptyMatrix<float>(n, n, 64), E = emptyMatrix<float>(n, n, 64);
+
+        auto const [Et, Dt] = utils::stats<3u>([&] noexcept
+        {
+            Matrix<float> P = emptyMatrix<float>(n, n, 64);
+            sgemm('N', 'N', 1.f, A, B, 0.f, P);
+            Matrix<float> S = emptyMatrix<float>(n, n, 64);
+            for(int i = 0; i < n; ++i)
+            for(int j = 0; j < n; ++j)
+                S[i][j] = P[i][j] + C[i][j];
+            D = std::move(S);
+        });
+        auto const [Ee, De] = utils::stats<3u>([&] noexcept
+        {
+            E = A * B + C;
+        });
+        auto const [Ei, Di] = utils::stats<3u>([&] noexcept
+        {
+            E = A * B + E; // in place: the beta of the sgemm
+        });
+
+        // n, ms: temporaries, expression, in place
+        std::cout << n << " " << 1000. * Et << " " << 1000. * Ee << " " << 1000. * Ei << std::endl;
+    }
+    return 0;
+}
+
+// attention scores on the [batch, seq, heads, dim] layout, "bqhd,bkhd->bhqk": einsum on strided views
+// against permuting Q and K to [batch, heads, seq, dim] and a strided-batched sgemm
+int einsum()
+{
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+
+    for(int const s : { 128, 256, 512 })
+    {
+        int const b = 4, h = 12, d = 64;
+        buf_t Q(b * s * h * d), K(b * s * h * d), Qp(Q.n), Kp(K.n), S(b * h * s * s), P(S.n);
+        for(int i = 0; i < Q.n; ++i)
+        {
+            Q.p[i] = float(i % 7) / 7.f - .5f;
+            K.p[i] = float(i % 11) / 11.f - .5f;
+        }
+
+        auto const [Ee, De] = utils::stats<3u>([&] noexcept
+        {
+            ::einsum("bqhd,bkhd->bhqk", 1.f, make_view<const float>(Q.p, { b, s, h, d }), make_view<const float>(K.p, { b, s, h, d }), 0.f, make_view(S.p, { b, h, s, s }), &pool);
+        });
+        auto const [Ep, Dp] = utils::stats<3u>([&] noexcept
+        {
+            for(int x = 0; x < b; ++x)
+            for(int q = 0; q < s; ++q)
+            for(int y = 0; y < h; ++y)
+            {
+                long const from = ((long(x) * s + q) * h + y) * d, to = ((long(x) * h + y) * s + q) * d;
+                std::copy_n(Q.p + from, d, Qp.p + to);
+                std::copy_n(K.p + from, d, Kp.p + to);
+            }
+            sgemm_strided_batched('N', 'T', s, s, d, 1.f, Qp.p, d, long(s) * d, Kp.p, d, long(s) * d, 0.f, P.p, s, long(s) * s, b * h, &pool);
+        });
+
+        double e = 0.;
+        for(int i = 0; i < S.n; ++i)
+            e = std::max(e, double(std::abs(S.p[i] - P.p[i])));
+
+        // seq, ms: einsum, permute + batched sgemm; max |difference|
+        std::cout << s << " " << 1000. * Ee << " " << 1000. * Ep << " " << e << std::endl;
+    }
+    return 0;
+}
+
+// blocked strsm (left, lower), sgetrf and spotrf: time; share of the flops in the sgemm (ssyrk for spotrf)
+// updates; max error in double: of X against forward substitution, of L U against P A and of L L^T against A
+int factor()
+{
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    int const nb = 64;
+
+    for(int n = 512; n <= 2048; n *= 2)
+    {
+        std::vector<float> G(std::size_t(n) * n), T(std::size_t(n) * n), S(std::size_t(n) * n), X(std::size_t(n) * n);
+        for(std::size_t i = 0, h = 12345; i < G.size(); ++i)
+        {
+            h = h * 6364136223846793005ull + 1442695040888963407ull;
+            G[i] = float(h >> 40 & 0xFFFF) / 65535.f - .5f;
+        }
+        for(int i = 0; i < n; ++i)
+        for(int j = 0; j < n; ++j)
+        {
+            T[i * n + j] = j < i ? G[i * n + j] / float(n) : j == i ? 1.f + G[i * n + j] * G[i * n + j] : 0.f; // well conditioned
+            S[i * n + j] = i == j ? float(n) : (G[i * n + j] + G[j * n + i]) / 2.f;                          // diagonally dominant
+        }
+        std::vector<int> ipiv(n);
+
+        auto const [Et, Dt] = utils::stats<3u>([&] noexcept
+        {
+            X = G;
+            strsm('L', 'L', 'N', 'N', n, n, 1.f, T.data(), n, X.data(), n, &pool, nb);
+        });
+        std::vector<float> LU = G, L = S;
+        auto const [El, Dl] = utils::stats<3u>([&] noexcept
+        {
+            LU = G;
+            sgetrf(n, n, LU.data(), n, ipiv.data(), &pool, nb);
+        });
+        auto const [Ec, Dc] = utils::stats<3u>([&] noexcept
+        {
+            L = S;
+            spotrf(n, L.data(), n, &pool, nb);
+        });
+
+        double ft = 0., fl = 0., fc = 0.; // update flops
+        for(int k = 0; k < n; k += nb)
+        {
+            double const r = std::max(0, n - k - nb), kb = std::min(nb, n - k);
+            ft += 2. * r * n * kb;
+            fl += 2. * r * r * kb;
+            fc += r * r * kb;
+        }
+
+        double et = 0., el = 0., ec = 0.;
+        std::vector<double> y(n);
+        for(int j = 0; j < n; ++j) // column j of X
+        {
+            for(int i = 0; i < n; ++i)
+            {
+                double s = G[i * n + j];
+                for(int p = 0; p < i; ++p)
+                    s -= double(T[i * n + p]) * y[p];
+                y[i] = s / T[i * n + i];
+                et = std::max(et, std::abs(y[i] - X[i * n + j]));
+            }
+        }
+        std::vector<float> PA = G;
+        for(int i = 0; i < n; ++i)
+            std::swap_ranges(&PA[i * n], &PA[i * n] + n, &PA[ipiv[i] * n]);
+        for(int i = 0; i < n; ++i)
+        for(int j = 0; j < n; ++j)
+        {
+            double a = i <= j ? LU[i * n + j] : 0., c = 0.;
+            for(int p = 0; p < std::min(i, j + 1); ++p)
+                a += double(LU[i * n + p]) * LU[p * n + j];
+            el = std::max(el, std::abs(a - PA[i * n + j]));
+            if(j > i)
+                continue;
+            for(int p = 0; p <= j; ++p)
+                c += double(L[i * n + p]) * L[j * n + p];
+            ec = std::max(ec, std::abs(c - S[i * n + j]));
+        }
+
+        // n, ms: strsm, sgetrf, spotrf; % of the flops in the updates: the same; max |error|: the same
+        std::cout << n << " " << 1000. * Et << " " << 1000. * El << " " << 1000. * Ec
+                  << " " << 100. * ft / (double(n) * n * n) << " " << 100. * fl / (2. / 3. * n * n * n) << " " << 100. * fc / (1. / 3. * n * n * n)
+                  << " " << et << " " << el << " " << ec << std::endl;
+    }
+    return 0;
+}
+
+// sgemv, ssyrk and ssymm against the sgemm computing the same: time of both, flops as % of the
+// sgemm's (a triangle for ssyrk) and max |difference|; sgemv against an n x 1 product
+int symm()
+{
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+
+    for(int n = 512; n <= 2048; n *= 2)
+    {
+        std::vector<float> A(std::size_t(n) * n), S(std::size_t(n) * n), B(std::size_t(n) * n), C(std::size_t(n) * n), R(std::size_t(n) * n);
+        for(std::size_t i = 0, h = 12345; i < A.size(); ++i)
+        {
+            h = h * 6364136223846793005ull + 1442695040888963407ull;
+            A[i] = float(h >> 40 & 0xFFFF) / 65535.f - .5f;
+            B[i] = float(h >> 20 & 0xFFFF) / 65535.f - .5f;
+        }
+        for(int i = 0; i < n; ++i)
+        for(int j = 0; j < n; ++j)
+            S[i * n + j] = A[std::max(i, j) * n + std::min(i, j)]; // the lower triangle of A, mirrored
+
+        auto line = [&](char const * name, double Er, double Eg, double share, double e)
+        {
+            // routine, n, ms: routine, sgemm; flops % of the sgemm's, max |routine - sgemm|
+            std::cout << name << " " << n << " " << 1000. * Er << " " << 1000. * Eg << " " << share << " " << e << std::endl;
+        };
+        auto diff = [&](int rows, int cols, bool lower)
+        {
+            double e = 0.;
+            for(int i = 0; i < rows; ++i)
+            for(int j = 0; j < (lower ? i + 1 : cols); ++j)
+                e = std::max(e, double(std::abs(C[i * cols + j] - R[i * cols + j])));
+            return e;
+        };
+
+        for(char const trans : { 'N', 'T' })
+        {
+            auto const [Er, Dr] = utils::stats<3u>([&] noexcept
+            {
+                sgemv(trans, n, n, 1.f, A.data(), n, B.data(), 0.f, C.data(), &pool);
+            });
+            auto const [Eg, Dg] = utils::stats<3u>([&] noexcept
+            {
+                sgemm(trans, 'N', n, 1, n, 1.f, A.data(), n, B.data(), 1, 0.f, R.data(), 1, pool);
+            });
+            line(trans == 'N' ? "sgemv_n" : "sgemv_t", Er, Eg, 100., diff(n, 1, false));
+        }
+
+        auto const [Ek, Dk] = utils::stats<3u>([&] noexcept
+        {
+            ssyrk('L', 'N', n, n, 1.f, A.data(), n, 0.f, C.data(), n, &pool);
+        });
+        auto const [Egk, Dgk] = utils::stats<3u>([&] noexcept
+        {
+            sgemm('N', 'T', n, n, n, 1.f, A.data(), n, A.data(), n, 0.f, R.data(), n, pool);
+        });
+        line("ssyrk", Ek, Egk, 100. * (n + 1.) / (2. * n), diff(n, n, true));
+
+        auto const [Em, Dm] = utils::stats<3u>([&] noexcept
+        {
+            ssymm('L', 'L', n, n, 1.f, A.data(), n, B.data(), n, 0.f, C.data(), n, &pool);
+        });
+        auto const [Egm, Dgm] = utils::stats<3u>([&] noexcept
+        {
+            sgemm('N', 'N', n, n, n, 1.f, S.data(), n, B.data(), n, 0.f, R.data(), n, pool);
+        });
+        line("ssymm", Em, Egm, 100., diff(n, n, false));
+    }
+    return 0;
+}
+
+// u8 x s8 -> s32 and requantized u8 against the sgemm on the same shapes and pool: GFLOPS / GOPS,
+// and max |s32 - sgemm| on small integers, where the fp32 sums are exact
+int int8()
+{
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    std::cout << "# int8 kernel: " << ikernel().name << std::endl;
+
+    for(auto const & [M, N, K] : { std::tuple{ 512, 512, 512 }, { 1024, 1024, 1024 }, { 2048, 2048, 2048 }, { 4096, 1024, 1024 }, { 256, 4096, 2048 } })
+    {
+        std::vector<uint8_t> A(std::size_t(M) * K);
+        std::vector< int8_t> B(std::size_t(K) * N);
+        std::vector<uint8_t> Q(std::size_t(M) * N);
+        std::vector<int32_t> C(std::size_t(M) * N);
+        buf_t Af(M * K), Bf(K * N), Cf(M * N);
+        for(int i = 0; i < M * K; ++i) Af.p[i] = A[i] = uint8_t(i % 16);
+        for(int i = 0; i < K * N; ++i) Bf.p[i] = B[i] = int8_t(i % 15 - 7);
+
+        std::vector<float> as(M, 1.f / 16.f), bs(N, 1.f / 8.f);
+        quant_t const q = { as.data(), nullptr, bs.data(), nullptr, float(K) / 64.f, 128 };
+
+        auto const [Ef, Df] = utils::stats<3u>([&] noexcept
+        {
+            sgemm('N', 'N', M, N, K, 1.f, Af.p, K, Bf.p, N, 0.f, Cf.p, N, pool);
+        });
+        auto const [Ei, Di] = utils::stats<3u>([&] noexcept
+        {
+            gemm_u8s8s32(M, N, K, A.data(), K, B.data(), N, C.data(), N, ikernel(), &pool);
+        });
+        auto const [Eq, Dq] = utils::stats<3u>([&] noexcept
+        {
+            qgemm(M, N, K, A.data(), K, B.data(), N, q, Q.data(), N, &pool);
+        });
+
+        double e = 0.;
+        for(int i = 0; i < M * N; ++i)
+            e = std::max(e, std::abs(double(C[i]) - Cf.p[i]));
+
+        // M N K, GFLOPS sgemm, GOPS: u8s8s32, qgemm; speedup over sgemm: the same; max |s32 - sgemm|
+        double const op = 2e-9 * M * N * K;
+        std::cout << M << " " << N << " " << K << " " << op / Ef << " " << op / Ei << " " << op / Eq
+                  << " " << Ef / Ei << " " << Ef / Eq << " " << e << std::endl;
+    }
+    return 0;
+}
+
+int half()
+{
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+
+    // fp32 A and B together 1.5 times the L3, so that sgemm streams them from memory: long K, tall A, wide B
+    long const e = 3l * std::max(caches().L3.size, 1 << 20) / 4 / 2 / 64 * 64; // floats
+    std::cout << "# kernel: " << kernel().name << ", threads: " << pool.size() << ", L3 " << caches().L3.size / 1024 << "K" << std::endl;
+
+    for(auto const & [M, N, K] : { std::tuple{ 512, 512, int(e / 1024) }, { int(e / 256), 256, 256 }, { 256, int(e / 256), 256 } })
+    {
+        // multiples of 1/8 in [-1, 1): exact in bf16 and fp16, and so are the fp32 sums for K < 2^18
+        std::vector<float>  A(std::size_t(M) * K), B(std::size_t(K) * N), Cf(std::size_t(M) * N), C(std::size_t(M) * N);
+        std::vector<bf16_t> Ab(A.size()), Bb(B.size());
+        std::vector<fp16_t> Ah(A.size()), Bh(B.size());
+        for(std::size_t i = 0; i < A.size(); ++i) A[i] = float(int(i % 16) - 8) / 8.f, Ab[i] = to_bf16(A[i]), Ah[i] = to_fp16(A[i]);
+        for(std::size_t i = 0; i < B.size(); ++i) B[i] = float(int(i % 13) - 6) / 8.f, Bb[i] = to_bf16(B[i]), Bh[i] = to_fp16(B[i]);
+
+        auto const [Ef, Df] = utils::stats<3u>([&] noexcept
+        {
+            gemm(M, N, K, A.data(), B.data(), Cf.data(), pool);
+        });
+
+        auto const error = [&]
+        {
+            double e = 0.;
+            for(std::size_t i = 0; i < C.size(); ++i)
+                e = std::max(e, double(std::abs(C[i] - Cf[i])));
+            return e;
+        };
+
+        auto const [Eb, Db] = utils::stats<3u>([&] noexcept
+        {
+            gemm(M, N, K, Ab.data(), Bb.data(), C.data(), pool);
+        });
+        double const eb = error();
+
+        auto const [Eh, Dh] = utils::stats<3u>([&] noexcept
+        {
+            gemm(M, N, K, Ah.data(), Bh.data(), C.data(), pool);
+        });
+        double const eh = error();
+
+        // M N K, GFLOPS: sgemm, bf16, fp16; speedup over sgemm: bf16, fp16; max |C - sgemm|: bf16, fp16
+        double const flop = 2e-9 * M * N * K;
+        std::cout << M << " " << N << " " << K << " " << flop / Ef << " " << flop / Eb << " " << flop / Eh
+                  << " " << Ef / Eb << " " << Ef / Eh << " " << eb << " " << eh << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    if(argc > 1 && std::string_view(argv[1]) == "half")
+        return half();
+    if(argc > 1 && std::string_view(argv[1]) == "int8")
+        return int8();
+    if(argc > 1 && std::string_view(argv[1]) == "symm")
+        return symm();
+    if(argc > 1 && std::string_view(argv[1]) == "factor")
+        return factor();
+    if(argc > 1 && std::string_view(argv[1]) == "einsum")
+        return einsum();
+    if(argc > 1 && std::string_view(argv[1]) == "expr")
+        return expressions();
+    if(argc > 1 && std::string_view(argv[1]) == "transpose")
+        return transpose();
+    if(argc > 1 && std::string_view(argv[1]) == "cgemm")
+        return cgemm();
+    if(argc > 1 && std::string_view(argv[1]) == "conv")
+        return conv();
+    if(argc > 1 && std::string_view(argv[1]) == "strassen")
+        return strassen();
+    if(argc > 1 && std::string_view(argv[1]) == "spmm")
+        return spmm();
+
+    std::cout << "# kernel: " << kernel().name << std::endl;
+    std::cout << "# caches: " << caches()  << std::endl;
+
+    for(int n = 192; n <= 3072; n += 192)
+    {
+        buf_t A(n * n), B(n * n), C(n * n);
+        GemmPlan plan(n, n, n);
+        std::cout << "# " << plan.params() << std::endl;
+
+        for(int i = 0; i < n * n; ++i)
+        {
+            A.p[i] = 1.f;
+            B.p[i] = 1.f;
+        }
+
+        auto const [Es, Ds] = utils::stats<4u>([&] noexcept
+        {
+            gemm(n, n, n, A.p, B.p, C.p);
+        });
+        auto const [Ep, Dp] = utils::stats<4u>([&] noexcept
+        {
+            plan(A.p, B.p, C.p);
+        });
+
+        // GFLOPS: serial, parallel; speedup
+        double const flop = 2. * n * n * n;
+        std::cout << n << " " << 1e-9 * flop / Es
+                       << " " << 1e-9 * flop / Ep
+                       << " " << Es / Ep << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+#pragma once
+#include "tools/threadpool.h"
+#include "tools/simd.h"
+#include "pure/profile.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using vf32 = vf32t<8>;
+[[assume(vf32::size() % 2u == 0u)]];
+
+f32 * alloc(std::size_t const n) noexcept
+{
+    f32 * ptr = (f32*) std::aligned_alloc(64u, 4u * n);
+    memset(ptr, 0u, 4u * n); 
+    return ptr;
+}
+
+
+template
+<
+    std::size_t RegPackSize,
+    std::size_t RegSize
+>   [[using gnu : hot]]
+void kernel( f32  const * const a
+           , vf32 const * const b
+           , vf32       * const c
+           , std::size_t const ii
+           , std::size_t const jj
+           , std::size_t const le
+           , std::size_t const ri
+           , std::size_t const N
+           ) noexcept
+{
+    [[assume(a != nullptr)]];
+    [[assume(b != nullptr)]];
+    [[assume(c != nullptr)]];
+    [[assume(N > 0u)]];
+
+    // Process N elements at once
+    // Use 2^K-float regs then:
+    //
+    //      N / 2^K = M x 2,
+    //
+    // M - rows No of registers tile. E.g.:
+    //
+    //             Tile (pack)
+    //
+    // [][][][][][][][] | [][][][][][][][]
+    // -----------------|-----------------
+    // [][][][][][][][] | [][][][][][][][]
+    // -----------------|-----------------
+    // [][][][][][][][] | [][][][][][][][]
+    // -----------------|-----------------
+    // [][][][][][][][] | [][][][][][][][]
+    //                .....
+    // [][][][][][][][] | [][][][][][][][]
+    //
+    
+    vf32 pack[RegPackSize][2u] = {0.f};
+
+    for(std::size_t k = le; k < ri         ; ++k)
+    for(std::size_t i = 0u; i < RegPackSize; ++i)
+    {
+        vf32 const ak = a[(ii + i) * N + k];
+
+        for(std::size_t j = 0u; j < 2u; ++j)
+            pack[i][j] += ak * b[(N * k + jj) / RegSize + j];
+    }
+
+    for(std::size_t i = 0u; i < RegPackSize; ++i)
+    for(std::size_t j = 0u; j < 2u         ; ++j)
+        c[((ii + i) * N  + jj) / RegSize + j] += pack[i][j];
+}
+
+template
+<
+    std::size_t ProcessElemNo,
+    std::size_t RegSize = vf32::size()
+>   [[using gnu : hot]]
+void matmul( f32 const * const A
+           , f32 const * const B
+           , f32       * const C
+           , std::size_t const N
+           , ThreadPool        & pool
+           ) noexcept
+{
+    [[assume(A != nullptr)]];
+    [[assume(B != nullptr)]];
+    [[assume(C != nullptr)]];
+    [[assume(N > 0u)]];
+
+    constexpr std::size_t Reg2Size    = RegSize * 2u;
+    constexpr std::size_t RegPackSize = ProcessElemNo / Reg2Size;
+
+    std::size_t const Nx = (N + RegPackSize - 1u) / RegPackSize * RegPackSize;
+    std::size_t const Ny = (N + Reg2Size    - 1u) / Reg2Size    * Reg2Size;
+
+    // padded copies of A and B and the padded C, made per call (zeroed by alloc)
+    f32 * const a = alloc(Nx * Ny);
+    f32 * const b = alloc(N  * Ny);
+    f32 * const c = alloc(Nx * Ny);
+
+    for(std::size_t i = 0u; i < N; ++i)
+    {
+        std::memcpy(&a[i * Ny], &A[i * N], 4u * N);
+        std::memcpy(&b[i * Ny], &B[i * N], 4u * N);
+    }
+
+    std::size_t const u = ProcessElemNo;
+    std::size_t const s3 = u;            // Cols No of B
+    std::size_t const s2 = 2u * u;       // Rows No of A
+    std::size_t const s1 = 4u * u;       // Rows No of B
+
+    // K-split when the C tiles alone cannot feed the threads: part p accumulates
+    // its range of K blocks into a private copy of c, the copies are summed after
+    std::size_t const tiles  = (Ny + s3 - 1u) / s3 * ((Nx + s2 - 1u) / s2);
+    std::size_t const blocks = (N  + s1 - 1u) / s1;
+    std::size_t const T      = std::max(1u, pool.size());
+    std::size_t const parts  = tiles >= T ? 1u : std::min(blocks, (T + tiles - 1u) / tiles);
+
+    std::vector<f32 *> part(parts, c);
+    for(std::size_t p = 1u; p < parts; ++p)
+        part[p] = alloc(Nx * Ny);
+
+    for(std::size_t p  = 0u; p  < parts; ++p )
+    for(std::size_t i3 = 0u; i3 < Ny; i3 += s3)
+    for(std::size_t i2 = 0u; i2 < Nx; i2 += s2)
+        pool.enqueue([=, &part] noexcept
+        {
+            for(std::size_t kb = blocks * p / parts; kb < blocks * (p + 1u) / parts; ++kb)
+            for(std::size_t ii = i2; ii < std::min(Nx, i2 + s2); ii += RegPackSize)
+            for(std::size_t jj = i3; jj < std::min(Ny, i3 + s3); jj += Reg2Size   )
+                kernel<RegPackSize, RegSize>
+                (
+                    a, 
+                    reinterpret_cast<vf32 const * const>(b), 
+                    reinterpret_cast<vf32       * const>(part[p]), 
+                    
+                    ii, 
+                    jj, 
+                    kb * s1, 
+                    std::min(kb * s1 + s1, N), 
+                    Ny
+                );
+        });
+    pool.wait();
+
+    if(parts > 1u)
+    {
+        for(std::size_t t = 0u; t < T; ++t)
+            pool.enqueue([=, &part] noexcept
+            {
+                auto * const dst = reinterpret_cast<vf32 * const>(c);
+
+                for(std::size_t i = Nx * Ny / RegSize * t / T; i < Nx * Ny / RegSize * (t + 1u) / T; ++i)
+                for(std::size_t p = 1u; p < parts; ++p)
+                    dst[i] += reinterpret_cast<vf32 const * const>(part[p])[i];
+            });
+        pool.wait();
+
+        for(std::size_t p = 1u; p < parts; ++p)
+            std::free(part[p]);
+    }
+
+    for(std::size_t i = 0u; i < N; ++i)
+        std::memcpy
+        (
+            &C[i * N ], 
+            &c[i * Ny], 
+              4u * N
+        );
+
+    std::free(a);
+    std::free(b);
+    std::free(c);
+}
+
+template
+<
+    std::size_t ProcessElemNo,
+    std::size_t RegSize = vf32::size()
+>
+void matmul( f32 const * const A
+           , f32 const * const B
+           , f32       * const C
+           , std::size_t const N
+           , std::size_t const threads = std::thread::hardware_concurrency()
+           ) noexcept
+{
+    ThreadPool pool(threads);
+    matmul<ProcessElemNo, RegSize>(A, B, C, N, pool);
+}
+
+// ProcessElemNo candidates, the profile picks one at run time
+template<typename F>
+void withProcessElemNo(std::size_t const processElemNo, F &&f) noexcept
+{
+    switch(processElemNo)
+    {
+        case  48u: return f(std::integral_constant<std::size_t,  48u>{});
+        case 192u: return f(std::integral_constant<std::size_t, 192u>{});
+        default  : return f(std::integral_constant<std::size_t,  96u>{});
+    }
+}
+
+void matmulTuned( f32 const * const A
+                , f32 const * const B
+                , f32       * const C
+                , std::size_t const N
+                , std::size_t const threads = std::thread::hardware_concurrency()
+                ) noexcept
+{
+    withProcessElemNo(profile().ProcessElemNo, [&](auto const P) noexcept
+    {
+        matmul<P()>(A, B, C, N, threads);
+    });
+}
+
+void matmulTuned( f32 const * const A
+                , f32 const * const B
+                , f32       * const C
+                , std::size_t const N
+                , ThreadPool        & pool
+                ) noexcept
+{
+    withProcessElemNo(profile().ProcessElemNo, [&](auto const P) noexcept
+    {
+        matmul<P()>(A, B, C, N, pool);
+    });
+}
@@ -1,29 +1,45 @@
-template<std::size_t Abi>
+template<typename T, typename Acc, std::size_t Abi>
 void macro( std::size_t const M
           , std::size_t const N
           , std::size_t const K
-          , const float * A
-          , const float * B, std::size_t LDB, float * bufB, bool notReordered
-          ,       float * C, std::size_t LDC
+          , const T * A
+          , const T * B, std::size_t LDB, T * bufB, bool notReordered
+          ,     Acc * C, std::size_t LDC
        // , ThreadPool &pool   
           ) noexcept
 {
-    for(std::size_t j = 0; j < N; j += 16)
+    constexpr std::size_t NR = 2u * Abi;
+
+    for(std::size_t j = 0; j < N; j += NR)
     {
+        std::size_t const dN = std::min(N, j + NR) - j;
+
         if(notReordered)
-           reorderB<Abi>(K, B + j, LDB, bufB + K * j);
+           reorderB<T, NR>(K, dN, B + j, LDB, bufB + K * j);
 
         for(std::size_t i = 0; i < M; i += 6)
-            micro<Abi>
-            (
-                K, A + i * K, 1, 6, 
-                bufB + K * j,  16, 
-                C + i * LDC + j, LDC
-            );
+        {
+            std::size_t const dM = std::min(M, i + 6) - i;
+
+            if(dM == 6 && dN == NR)
+                micro<T, Acc, Abi>
+                (
+                    K, A + i * K, 
+                    bufB + K * j, 
+                    C + i * LDC + j, LDC
+                );
+            else
+                microTail<T, Acc, Abi>
+                (
+                    dM, dN, K, A + i * K, 
+                    bufB + K * j, 
+                    C + i * LDC + j, LDC
+                );
+        }
         /*
          *  pool.addTaskSeeFuture
          *  (
-         *      micro<Abi>(...)
+         *      micro<T, Acc, Abi>(...)
          *  )
          */
     }
@@ -1,104 +1,119 @@
 
-template<std::size_t Abi>
+// 6 x 2*Abi tile of C += A * B: A and B are packed in T,
+// the products are summed in Acc (Abi lanes of Acc per register)
+template<typename T, typename Acc, std::size_t Abi>
 void micro( std::size_t const K
-          , std::size_t const step
-          , const float * A, std::size_t LDA
-          , const float * B, std::size_t LDB
-          ,       float * C, std::size_t LDC
+          , const T * A
+          , const T * B
+          ,     Acc * C, std::size_t LDC
           ) noexcept
 {
-    vf32t<Abi> c00, c10, c20, c30, c40, c50,
-               c01, c11, c21, c31, c41, c51;
+    using V = vt<Acc, Abi>;
+    using S = vt<T  , Abi>;
 
-    std::size_t const offset0 = LDA * 0u;
-    std::size_t const offset1 = LDA * 1u;
-    std::size_t const offset2 = LDA * 2u;
-    std::size_t const offset3 = LDA * 3u;
-    std::size_t const offset4 = LDA * 4u;
-    std::size_t const offset5 = LDA * 5u;
+    V c00 = 0, c10 = 0, c20 = 0, c30 = 0, c40 = 0, c50 = 0,
+      c01 = 0, c11 = 0, c21 = 0, c31 = 0, c41 = 0, c51 = 0;
 
 
-    vf32t<Abi> a0, a1,
-               b0, b1;
+    V a0, a1,
+      b0, b1;
 
     for (std::size_t k = 0u; k < K; ++k)
     {
-        b0.copy_from(B + 0u     , stdx::vector_aligned);
-        b1.copy_from(B + 8u     , stdx::vector_aligned);
-        a0.copy_from(&A[offset0], stdx::vector_aligned);
-        a1.copy_from(&A[offset0], stdx::vector_aligned);
+        b0 = stdx::static_simd_cast<V>(S(B + 0u , stdx::element_aligned));
+        b1 = stdx::static_simd_cast<V>(S(B + Abi, stdx::element_aligned));
+        a0 = Acc(A[0]);
+        a1 = Acc(A[1]);
 
         c00 = a0 * b0 + c00;
         c01 = a0 * b1 + c01;
         c10 = a1 * b0 + c10;
         c11 = a1 * b1 + c11;
         
-        a0.copy_from(&A[offset2], stdx::vector_aligned);
-        a1.copy_from(&A[offset3], stdx::vector_aligned);
+        a0 = Acc(A[2]);
+        a1 = Acc(A[3]);
         
         c20 = a0 * b0 + c20;
         c21 = a0 * b1 + c21;
         c30 = a1 * b0 + c30;
         c31 = a1 * b1 + c31;
         
-        a0.copy_from(&A[offset4], stdx::vector_aligned);
-        a1.copy_from(&A[offset5], stdx::vector_aligned);
+        a0 = Acc(A[4]);
+        a1 = Acc(A[5]);
        
         c40 = a0 * b0 + c40;
         c41 = a0 * b1 + c41;
         c50 = a1 * b0 + c50;
         c51 = a1 * b1 + c51;
         
-        B += LDB; A += step;
+        B += 2u * Abi; A += 6u;
     }
 
 
-    vf32t<Abi> tmp;
+    V tmp;
 
 
-            tmp.copy_from(C + 0, stdx::vector_aligned);
-    (c00 + tmp).copy_to  (C + 0, stdx::vector_aligned);
+            tmp.copy_from(C + 0  , stdx::element_aligned);
+    (c00 + tmp).copy_to  (C + 0  , stdx::element_aligned);
 
-            tmp.copy_from(C + 8, stdx::vector_aligned);
-    (c01 + tmp).copy_to  (C + 8, stdx::vector_aligned);
+            tmp.copy_from(C + Abi, stdx::element_aligned);
+    (c01 + tmp).copy_to  (C + Abi, stdx::element_aligned);
 
                           C += LDC;
 
-            tmp.copy_from(C + 0, stdx::vector_aligned);
-    (c10 + tmp).copy_to  (C + 0, stdx::vector_aligned);
+            tmp.copy_from(C + 0  , stdx::element_aligned);
+    (c10 + tmp).copy_to  (C + 0  , stdx::element_aligned);
 
-            tmp.copy_from(C + 8, stdx::vector_aligned);
-    (c11 + tmp).copy_to  (C + 8, stdx::vector_aligned);
+            tmp.copy_from(C + Abi, stdx::element_aligned);
+    (c11 + tmp).copy_to  (C + Abi, stdx::element_aligned);
     
                           C += LDC;
 
-            tmp.copy_from(C + 0, stdx::vector_aligned);
-    (c20 + tmp).copy_to  (C + 0, stdx::vector_aligned);
+            tmp.copy_from(C + 0  , stdx::element_aligned);
+    (c20 + tmp).copy_to  (C + 0  , stdx::element_aligned);
 
-            tmp.copy_from(C + 8, stdx::vector_aligned);
-    (c21 + tmp).copy_to  (C + 8, stdx::vector_aligned);
+            tmp.copy_from(C + Abi, stdx::element_aligned);
+    (c21 + tmp).copy_to  (C + Abi, stdx::element_aligned);
     
                           C += LDC;
 
-            tmp.copy_from(C + 0, stdx::vector_aligned);
-    (c30 + tmp).copy_to  (C + 0, stdx::vector_aligned);
+            tmp.copy_from(C + 0  , stdx::element_aligned);
+    (c30 + tmp).copy_to  (C + 0  , stdx::element_aligned);
 
-            tmp.copy_from(C + 8, stdx::vector_aligned);
-    (c31 + tmp).copy_to  (C + 8, stdx::vector_aligned);
+            tmp.copy_from(C + Abi, stdx::element_aligned);
+    (c31 + tmp).copy_to  (C + Abi, stdx::element_aligned);
     
                           C += LDC;
 
-            tmp.copy_from(C + 0, stdx::vector_aligned);
-    (c40 + tmp).copy_to  (C + 0, stdx::vector_aligned);
+            tmp.copy_from(C + 0  , stdx::element_aligned);
+    (c40 + tmp).copy_to  (C + 0  , stdx::element_aligned);
 
-            tmp.copy_from(C + 8, stdx::vector_aligned);
-    (c41 + tmp).copy_to  (C + 8, stdx::vector_aligned);
+            tmp.copy_from(C + Abi, stdx::element_aligned);
+    (c41 + tmp).copy_to  (C + Abi, stdx::element_aligned);
     
                           C += LDC;
    
-            tmp.copy_from(C + 0, stdx::vector_aligned);
-    (c50 + tmp).copy_to  (C + 0, stdx::vector_aligned);
+            tmp.copy_from(C + 0  , stdx::element_aligned);
+    (c50 + tmp).copy_to  (C + 0  , stdx::element_aligned);
 
-            tmp.copy_from(C + 8, stdx::vector_aligned);
-    (c51 + tmp).copy_to  (C + 8, stdx::vector_aligned);
+            tmp.copy_from(C + Abi, stdx::element_aligned);
+    (c51 + tmp).copy_to  (C + Abi, stdx::element_aligned);
+}
+
+// M x N corner (M <= 6, N <= 2*Abi): the full tile goes to a local buffer
+template<typename T, typename Acc, std::size_t Abi>
+void microTail( std::size_t const M
+              , std::size_t const N
+              , std::size_t const K
+              , const T * A
+              , const T * B
+              ,     Acc * C, std::size_t LDC
+              ) noexcept
+{
+    Acc tile[6u * 2u * Abi] = {};
+    micro<T, Acc, Abi>(K, A, B, tile, 2u * Abi);
+
+    for(std::size_t i = 0u; i < M; ++i)
+        for(std::size_t j = 0u; j < N; ++j)
+            C[i * LDC + j] += tile[i * 2u * Abi + j];
 }
@@ -1,23 +1,32 @@
 #pragma once
-#include "tools/types.h"
-#include "tools/matrix.h"
-
-using T = f32;
+#include "../tools/types.h"
+#include "../tools/simd.h"
+#include "../tools/matrix.h"
+#include "../pure/cache.h"
+#include <type_traits>
 
+template<typename T>
 struct Buf
 {
-    f32 * p;
     std::size_t n;
+    T * p;
 
     Buf(std::size_t size) 
     : 
         n(size), 
-        p(static_cast<f32 *>(std::aligned_alloc(64u, size * 4u))) 
+        p(static_cast<T *>(std::aligned_alloc(64u, (size * sizeof(T) + 63u) / 64u * 64u))) 
     {}
 
+    Buf(Buf const &) = delete;
+
     ~Buf() { std::free(p); }
 };
 
+// lanes of Acc in a 256-bit register: 8 floats or 4 doubles,
+// register tile is 6 x 2*Abi, i.e. 6x16 for f32 and 6x8 for f64
+template<typename Acc>
+constexpr std::size_t Abi = 32u / sizeof(Acc);
+
 
 // LDA - leading dimension for A
 
@@ -25,6 +34,10 @@ struct Buf
 #include "micro.h"
 #include "macro.h"
 
+// C = A * B with T in memory and the sums kept in Acc:
+// multiply<f32> - sgemm, multiply<f64> - dgemm,
+// multiply<f32, f64> - fp32 storage with fp64 accumulation over the whole K
+template<typename T, typename Acc = T>
 Matrix<T> multiply( Matrix<T> const &A
                   , Matrix<T> const &B
                 //, ThreadPool & pool
@@ -34,22 +47,30 @@ Matrix<T> multiply( Matrix<T> const &A
                     , K = A.width
                     , N = B.width;
 
-    assert(K == N);
+    assert(K == B.height);
 
     Matrix<T> C = emptyMatrix<T>(N, M, 64);
-    
-    constexpr int L1 =       32 * 1024
-                , L2 =      256 * 1024
-                , L3 = 2 * 1024 * 1024;
+
+    // with a wider Acc partial sums over K blocks stay in Acc until the end
+    Matrix<Acc> wide = std::is_same_v<T, Acc> ? Matrix<Acc>{} : emptyMatrix<Acc>(N, M, 64);
+    Acc * const pC   = std::is_same_v<T, Acc> ? reinterpret_cast<Acc *>(C.memory.get()) : wide.memory.get();
+    std::size_t LDC  = std::is_same_v<T, Acc> ? C.memoryWidth : wide.memoryWidth;
+
+    constexpr std::size_t NR = 2u * Abi<Acc>;
+
+    cache_t const & c = caches();
+    std::size_t const L1 = c.L1.size
+                    , L2 = c.L2.size
+                    , L3 = c.L3.size;
 
     // mar"Буква" = macro kernel bandwidth 
     // e.g. marK = bandwidth of L1 = 512 bit
-    constexpr int marK = std::min(L1 / 4 / 16,   K) /  4 *  4;
-    constexpr int marM = std::min(L2 / 4 / marK, M) /  6 *  6;
-    constexpr int marN = std::min(L3 / 4 / marK, N) / 16 * 16;
+    std::size_t const marK = std::max<std::size_t>(std::min(L1 / sizeof(T) / NR, K), 1u);
+    std::size_t const marM = std::min(std::max<std::size_t>(L2 / sizeof(T) / marK /  6 *  6,  6), M);
+    std::size_t const marN = std::min(std::max<std::size_t>(L3 / sizeof(T) / marK / NR * NR, NR), N);
 
-    Buf bufB(marN * marK);
-    Buf bufA(marK * marM);
+    Buf<T> bufB((marN + NR - 1) / NR * NR * marK);
+    Buf<T> bufA((marM +  5) /  6 *  6 * marK);
 
     // chunk of B (chunk(B)) is stored in L3
     for(std::size_t j = 0u; j < N; j += marN)
@@ -66,22 +87,25 @@ Matrix<T> multiply( Matrix<T> const &A
             {
                 std::size_t const dM = std::min(M, i + marM) - i;
 
-                reorderA<ABI<4u>>(A.memory() + i * K + k, K, dM, dK, bufA.p);
-                macro   <ABI<8u>>
+                reorderA<T, 6u>(A[i] + k, A.memoryWidth, dM, dK, bufA.p);
+                macro   <T, Acc, Abi<Acc>>
                 (
                     dM, dN, dK,
                     bufA.p, 
-                    B.memory() + k * N + j, N, bufB.p, (i == 0u), 
-                    C.memory() + i * N + j, N
+                    B[k] + j, B.memoryWidth, bufB.p, (i == 0u), 
+                    pC + i * LDC + j, LDC
                 );
                 /*
-                 * pool.addTaskSeeFuture(macro<ABI<8u>>(...))
+                 * pool.addTaskSeeFuture(macro<T, Acc, Abi<Acc>>(...))
                  */
             }
         }
     }
+
+    if constexpr (!std::is_same_v<T, Acc>)
+        for(std::size_t i = 0u; i < M; ++i)
+            for(std::size_t j = 0u; j < N; ++j)
+                C[i][j] = T(wide[i][j]);
     
     return C;
 }
-
-
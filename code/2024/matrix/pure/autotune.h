@@ -0,0 +1,105 @@
+#pragma once
+#include "../tools/stats.h"
+#include <cmath>
+#include <vector>
+
+// Empirical search for the profile: for every supported kernel the block sizes
+// and the thread split are tuned one at a time (coordinate descent), each
+// candidate scored by the total time over a few representative shapes
+profile_t autotune(unsigned int threads, std::ostream & log)
+{
+    const int shapes[][3] = // M, N, K
+    {
+        { 1024, 1024, 1024 },
+        {  384, 2048, 1536 },
+        { 2048,  256,  512 },
+    };
+
+    int maxA = 0, maxB = 0, maxC = 0;
+    for (const auto & [M, N, K] : shapes)
+    {
+        maxA = std::max(maxA, M * K);
+        maxB = std::max(maxB, K * N);
+        maxC = std::max(maxC, M * N);
+    }
+
+    buf_t A(maxA), B(maxB), C(maxC);
+    for (int i = 0; i < maxA; ++i) A.p[i] = 1.f;
+    for (int i = 0; i < maxB; ++i) B.p[i] = 1.f;
+
+    ThreadPool pool(std::max(1u, threads));
+
+    auto score = [&](const kernel_t & ker, const profile_t & p)
+    {
+        double t = 0.;
+        for (const auto & [M, N, K] : shapes)
+        {
+            const blocking_t b = make_blocking(M, N, K, pool.size(), ker, caches(), p);
+
+            buf_t bufB(2 * bufB_size(b));
+            std::vector<buf_t> bufA;
+            for (int i = 0; i < b.tM * b.tN; ++i)
+                bufA.emplace_back(bufA_size(b));
+
+            t += utils::stats<3u>([&] noexcept
+            {
+                sgemm('N', 'N', M, N, K, 1.f, A.p, K, B.p, N, 0.f, C.p, N, b, bufB, bufA, pool);
+            }).first;
+        }
+        return t;
+    };
+
+    profile_t best;
+    double bestTime = INFINITY;
+
+    for (const kernel_t & ker : kernels)
+    {
+        if (!supported(ker))
+            continue;
+
+        profile_t p;
+        p.kernel = ker.name;
+        double t = score(ker, p);
+
+        if (t > 2. * bestTime) // kernels go best first, a far slower one is not worth tuning
+        {
+            log << "# " << p << ": " << t * 1000. << " ms, skipped" << std::endl;
+            continue;
+        }
+
+        auto sweep = [&](int profile_t::* field, std::vector<int> const & values)
+        {
+            for (int v : values)
+            {
+                profile_t q = p;
+                q.*field = v;
+
+                double tq = score(ker, q);
+                if (tq < t)
+                {
+                    t = tq;
+                    p = q;
+                }
+            }
+        };
+
+        const int MR = ker.MR, NR = ker.NR;
+        std::vector<int> tMs;
+        for (int d = 1; d <= int(pool.size()); ++d)
+            if (pool.size() % d == 0)
+                tMs.push_back(d);
+
+        sweep(&profile_t::mK, { 128, 192, 256, 384, 512, 768 });
+        sweep(&profile_t::mM, { 8 * MR, 16 * MR, 32 * MR, 64 * MR, 128 * MR });
+        sweep(&profile_t::mN, { 16 * NR, 32 * NR, 64 * NR, 128 * NR });
+        sweep(&profile_t::tM, tMs);
+
+        log << "# " << p << ": " << t * 1000. << " ms" << std::endl;
+        if (t < bestTime)
+        {
+            bestTime = t;
+            best = p;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+// 14x32 kernel: 28 zmm accumulators, 2 zmm for a row of B, broadcasts of A come from memory
+
+template<typename Epi>
+AVX512 void micro_14x32(int K, const float * A, const float * B, float * C, int ldc, const Epi & epi, int i0, int j0)
+{
+    __m512 c[14][2];
+
+    #pragma GCC unroll 14
+    for (int i = 0; i < 14; ++i)
+    {
+        c[i][0] = _mm512_setzero_ps();
+        c[i][1] = _mm512_setzero_ps();
+
+        // see micro_6x16
+        _mm_prefetch((const char *)(C + i * ldc +  0), _MM_HINT_T0);
+        _mm_prefetch((const char *)(C + i * ldc + 31), _MM_HINT_T0);
+    }
+
+    for (int k = 0; k < K; ++k, A += 14, B += 32) // cycle 1, see micro_6x16
+    {
+        __m512 b0 = _mm512_loadu_ps(B +  0);
+        __m512 b1 = _mm512_loadu_ps(B + 16);
+
+        #pragma GCC unroll 14
+        for (int i = 0; i < 14; ++i)
+        {
+            __m512 a = _mm512_set1_ps(A[i]);
+            c[i][0] = _mm512_fmadd_ps(a, b0, c[i][0]);
+            c[i][1] = _mm512_fmadd_ps(a, b1, c[i][1]);
+        }
+    }
+
+    #pragma GCC unroll 14
+    for (int i = 0; i < 14; ++i, C += ldc)
+    {
+        _mm512_storeu_ps(C +  0, epi(_mm512_add_ps(c[i][0], _mm512_loadu_ps(C +  0)), i0 + i, j0 +  0));
+        _mm512_storeu_ps(C + 16, epi(_mm512_add_ps(c[i][1], _mm512_loadu_ps(C + 16)), i0 + i, j0 + 16));
+    }
+}
+
+AVX512 void micro_14x32(int K, const float * A, const float * B, float * C, int ldc)
+{
+    micro_14x32(K, A, B, C, ldc, epi_none(), 0, 0);
+}
+
+// lanes [0, n) are set, n may be out of [0, 16]
+inline __mmask16 mask_16(int n)
+{
+    return n >= 16 ? 0xFFFF : n <= 0 ? 0 : (1u << n) - 1u;
+}
+
+AVX512 void micro_14x32_tail(int M, int N, int K, const float * A, const float * B, float * C, int ldc)
+{
+    alignas(64) float tile[14 * 32] = {};
+    micro_14x32(K, A, B, tile, 32);
+
+    const __mmask16 m0 = mask_16(N -  0);
+    const __mmask16 m1 = mask_16(N - 16);
+
+    for (int i = 0; i < M; ++i, C += ldc)
+    {
+        _mm512_mask_storeu_ps(C +  0, m0, _mm512_add_ps(_mm512_load_ps(tile + i * 32 +  0), _mm512_maskz_loadu_ps(m0, C +  0)));
+        _mm512_mask_storeu_ps(C + 16, m1, _mm512_add_ps(_mm512_load_ps(tile + i * 32 + 16), _mm512_maskz_loadu_ps(m1, C + 16)));
+    }
+}
+
+AVX512 void reorder_b_32(char trans, int K, int N, const float * B, int ldb, float * bufB) // N <= 32
+{
+    if (is_trans(trans))
+        return pack_b_generic<32>(trans, K, N, B, ldb, bufB);
+
+    const __mmask16 m0 = mask_16(N -  0);
+    const __mmask16 m1 = mask_16(N - 16);
+
+    for (int k = 0; k < K; ++k, B += ldb, bufB += 32)
+    {
+        _mm512_storeu_ps(bufB +  0, _mm512_maskz_loadu_ps(m0, B +  0));
+        _mm512_storeu_ps(bufB + 16, _mm512_maskz_loadu_ps(m1, B + 16));
+    }
+}
+
+AVX512 void transpose_16x16(__m512 * r) // in registers: r[i][j] <-> r[j][i], see transpose_8x8
+{
+    // the zero-masking forms: the plain ones leave GCC 12 warning about their undefined pass-through
+    const __mmask16 all = 0xFFFF;
+
+    __m512 t[16], u[16];
+
+    for (int i = 0; i < 16; i += 2)
+    {
+        t[i + 0] = _mm512_maskz_unpacklo_ps(all, r[i], r[i + 1]);
+        t[i + 1] = _mm512_maskz_unpackhi_ps(all, r[i], r[i + 1]);
+    }
+    for (int i = 0; i < 16; i += 4) // u[i + c]: column c of each 128-bit lane for rows i..i+3
+    {
+        u[i + 0] = _mm512_maskz_shuffle_ps(all, t[i + 0], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+        u[i + 1] = _mm512_maskz_shuffle_ps(all, t[i + 0], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+        u[i + 2] = _mm512_maskz_shuffle_ps(all, t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+        u[i + 3] = _mm512_maskz_shuffle_ps(all, t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+    }
+    for (int c = 0; c < 4; ++c) // gather the four lanes of each column
+    {
+        __m512 v0 = _mm512_maskz_shuffle_f32x4(all, u[c + 0], u[c +  4], _MM_SHUFFLE(2, 0, 2, 0));
+        __m512 w0 = _mm512_maskz_shuffle_f32x4(all, u[c + 0], u[c +  4], _MM_SHUFFLE(3, 1, 3, 1));
+        __m512 v1 = _mm512_maskz_shuffle_f32x4(all, u[c + 8], u[c + 12], _MM_SHUFFLE(2, 0, 2, 0));
+        __m512 w1 = _mm512_maskz_shuffle_f32x4(all, u[c + 8], u[c + 12], _MM_SHUFFLE(3, 1, 3, 1));
+
+        r[c +  0] = _mm512_maskz_shuffle_f32x4(all, v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+        r[c +  8] = _mm512_maskz_shuffle_f32x4(all, v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+        r[c +  4] = _mm512_maskz_shuffle_f32x4(all, w0, w1, _MM_SHUFFLE(2, 0, 2, 0));
+        r[c + 12] = _mm512_maskz_shuffle_f32x4(all, w0, w1, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+}
+
+AVX512 void reorder_a_14(char trans, const float * A, int lda, int M, int K, float alpha, float * bufA)
+{
+    const __m512    a   = _mm512_set1_ps(alpha);
+    const __mmask16 m14 = mask_16(14);
+
+    if (!is_trans(trans))
+    {
+        // A is stored as M x K: 16 k of 14 rows are transposed in registers,
+        // rows past M and the last two lanes are zero
+        for (int i = 0; i < M; i += 14, A += 14 * lda)
+        {
+            const int dM = std::min(M - i, 14);
+
+            for (int k = 0; k < K; k += 16)
+            {
+                const __mmask16 mk = mask_16(K - k);
+
+                __m512 r[16];
+                #pragma GCC unroll 16
+                for (int q = 0; q < 16; ++q)
+                    r[q] = q < dM ? _mm512_mul_ps(a, _mm512_maskz_loadu_ps(mk, A + q * lda + k)) : _mm512_setzero_ps();
+
+                transpose_16x16(r);
+
+                const int dK = std::min(K - k, 16);
+                for (int q = 0; q < dK; ++q, bufA += 14)
+                    _mm512_mask_storeu_ps(bufA, m14, r[q]);
+            }
+        }
+        return;
+    }
+
+    // A is stored as K x M: 14 contiguous floats per k
+
+    for (int i = 0; i < M; i += 14, A += 14)
+    {
+        const __mmask16 mi = mask_16(std::min(M - i, 14)); // tail rows are zero-padded up to 14
+
+        const float * pA = A;
+        for (int k = 0; k < K; ++k, pA += lda, bufA += 14)
+            _mm512_mask_storeu_ps(bufA, m14, _mm512_mul_ps(a, _mm512_maskz_loadu_ps(mi, pA)));
+    }
+}
@@ -0,0 +1,219 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <bit>
+#include <cstring>
+#include <vector>
+
+// Batched gemm: many independent small products, each one handled whole by one
+// thread. Square non-transposed 4..64 sizes go through compile-time kernels,
+// the rest through the blocked sgemm on a per-task workspace.
+
+// C = alpha * A * B + beta * C for fixed M x N x K, unrolled at compile time
+// (K up to 16 completely): a C row is N / W registers of W = min(N, L) lanes, L the lanes
+// of the ISA's register, and as many rows as leave one register per B vector are accumulated at once.
+// Vectors are GCC's, sized by W, so that the instance's target attribute picks the registers
+template<int M, int N, int K, int L, int Regs>
+[[gnu::always_inline]] inline void small_gemm_body( float alpha, const float * A, int lda
+                                                  ,              const float * B, int ldb
+                                                  , float beta ,       float * C, int ldc
+                                                  )
+{
+    constexpr int W  = std::min(N, L);
+    constexpr int R  = N / W;
+    constexpr int MB = std::min({ M, 8, int(std::bit_floor(unsigned(std::max(1, (Regs - 1) / R - 1)))) });
+    static_assert(N % W == 0 && M % MB == 0);
+
+    typedef float V __attribute__((vector_size(W * sizeof(float))));
+
+    for (int i = 0; i < M; i += MB)
+    {
+        V c[MB][R];
+
+        #pragma GCC unroll 8
+        for (int m = 0; m < MB; ++m)
+            #pragma GCC unroll 8
+            for (int r = 0; r < R; ++r)
+                c[m][r] = V{};
+
+        #pragma GCC unroll 16
+        for (int k = 0; k < K; ++k)
+        {
+            V b[R];
+            #pragma GCC unroll 8
+            for (int r = 0; r < R; ++r)
+                std::memcpy(&b[r], B + k * ldb + r * W, sizeof(V));
+
+            #pragma GCC unroll 8
+            for (int m = 0; m < MB; ++m)
+            {
+                const float a = A[(i + m) * lda + k];
+                #pragma GCC unroll 8
+                for (int r = 0; r < R; ++r)
+                    c[m][r] += a * b[r];
+            }
+        }
+
+        #pragma GCC unroll 8
+        for (int m = 0; m < MB; ++m)
+            #pragma GCC unroll 8
+            for (int r = 0; r < R; ++r)
+            {
+                float * pC = C + (i + m) * ldc + r * W;
+                V res = alpha * c[m][r];
+                if (beta != 0.f)
+                {
+                    V old;
+                    std::memcpy(&old, pC, sizeof(V));
+                    res += beta * old;
+                }
+                std::memcpy(pC, &res, sizeof(V));
+            }
+    }
+}
+
+// one instance per ISA, the same as the kernels of dispatch.h
+template<int M, int N, int K>
+void small_gemm( float alpha, const float * A, int lda
+               ,              const float * B, int ldb
+               , float beta ,       float * C, int ldc
+               )
+{
+    small_gemm_body<M, N, K, 4, 16>(alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+template<int M, int N, int K>
+AVX2 void small_gemm_avx2( float alpha, const float * A, int lda
+                         ,              const float * B, int ldb
+                         , float beta ,       float * C, int ldc
+                         )
+{
+    small_gemm_body<M, N, K, 8, 16>(alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+template<int M, int N, int K>
+AVX512 void small_gemm_avx512( float alpha, const float * A, int lda
+                             ,              const float * B, int ldb
+                             , float beta ,       float * C, int ldc
+                             )
+{
+    small_gemm_body<M, N, K, 16, 32>(alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+typedef void (*small_gemm_t)(float alpha, const float * A, int lda, const float * B, int ldb, float beta, float * C, int ldc);
+
+// the instance for the best ISA this CPU supports, checked as for kernel()
+template<int M, int N, int K>
+small_gemm_t select_small_gemm()
+{
+    static const small_gemm_t selected = find_kernel("avx512") ? small_gemm_avx512<M, N, K>
+                                       : find_kernel("avx2")   ? small_gemm_avx2<M, N, K>
+                                       :                         small_gemm<M, N, K>;
+    return selected;
+}
+
+// nullptr if there is no fixed-size kernel for the shape
+small_gemm_t find_small_gemm(char transA, char transB, int M, int N, int K)
+{
+    if (is_trans(transA) || is_trans(transB) || M != N || N != K)
+        return nullptr;
+
+    switch (M)
+    {
+        case  4: return select_small_gemm< 4,  4,  4>();
+        case  8: return select_small_gemm< 8,  8,  8>();
+        case 16: return select_small_gemm<16, 16, 16>();
+        case 32: return select_small_gemm<32, 32, 32>();
+        case 64: return select_small_gemm<64, 64, 64>();
+        default: return nullptr;
+    }
+}
+
+// matrix b of the batch is ptrA(b), ptrB(b), ptrC(b); pool == nullptr runs inline
+template<typename PA, typename PB, typename PC>
+void sgemm_batched( char transA, char transB, int M, int N, int K
+                  , float alpha, PA ptrA, int lda
+                  ,              PB ptrB, int ldb
+                  , float beta , PC ptrC, int ldc
+                  , int batch
+                  , ThreadPool * pool
+                  )
+{
+    if (batch <= 0)
+        return;
+
+    small_gemm_t small = find_small_gemm(transA, transB, M, N, K);
+
+    auto run = [=](int b0, int b1)
+    {
+        if (small)
+        {
+            for (int b = b0; b < b1; ++b)
+                small(alpha, ptrA(b), lda, ptrB(b), ldb, beta, ptrC(b), ldc);
+            return;
+        }
+
+        const blocking_t blocking = make_blocking(M, N, K, 1);
+        buf_t bufB(bufB_size(blocking));
+        buf_t bufA(bufA_size(blocking));
+
+        for (int b = b0; b < b1; ++b)
+            sgemm(transA, transB, M, N, K, alpha, ptrA(b), lda, ptrB(b), ldb, beta, ptrC(b), ldc, blocking, bufB, bufA);
+    };
+
+    if (!pool)
+        return run(0, batch);
+
+    const int T = std::min<int>(std::max(1u, pool->size()), batch);
+    for (int t = 0; t < T; ++t)
+        pool->enqueue([=] noexcept { run(long(batch) * t / T, long(batch) * (t + 1) / T); });
+    pool->wait();
+}
+
+// pointer-array batch
+void sgemm_batched( char transA, char transB, int M, int N, int K
+                  , float alpha, const float * const * A, int lda
+                  ,              const float * const * B, int ldb
+                  , float beta ,       float * const * C, int ldc
+                  , int batch
+                  , ThreadPool * pool = nullptr
+                  )
+{
+    sgemm_batched
+    (
+        transA, transB, M, N, K,
+        alpha, [A](int b) { return A[b]; }, lda,
+               [B](int b) { return B[b]; }, ldb,
+        beta , [C](int b) { return C[b]; }, ldc,
+        batch, pool
+    );
+}
+
+// strided batch: matrix b starts at A + b * strideA etc.
+void sgemm_strided_batched( char transA, char transB, int M, int N, int K
+                          , float alpha, const float * A, int lda, long strideA
+                          ,              const float * B, int ldb, long strideB
+                          , float beta ,       float * C, int ldc, long strideC
+                          , int batch
+                          , ThreadPool * pool = nullptr
+                          )
+{
+    sgemm_batched
+    (
+        transA, transB, M, N, K,
+        alpha, [=](int b) { return A + b * strideA; }, lda,
+               [=](int b) { return B + b * strideB; }, ldb,
+        beta , [=](int b) { return C + b * strideC; }, ldc,
+        batch, pool
+    );
+}
+
+void gemm_batched( int M, int N, int K
+                 , const float * const * A
+                 , const float * const * B
+                 ,       float * const * C
+                 , int batch
+                 , ThreadPool * pool = nullptr
+                 )
+{
+    sgemm_batched('N', 'N', M, N, K, 1.f, A, K, B, N, 0.f, C, N, batch, pool);
+}
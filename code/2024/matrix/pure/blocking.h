@@ -0,0 +1,57 @@
+#pragma once
+#include "cache.h"
+#include "profile.h"
+
+blocking_t make_blocking( int M, int N, int K, int threads
+                        , const kernel_t & ker
+                        , const cache_t & cache
+                        , const profile_t & tuned // nonzero fields override the derived ones
+                        )
+{
+    const int MR = ker.MR
+            , NR = ker.NR
+            , T  = std::max(1, threads);
+
+    // per-thread budget of each level: L1 and L2 are split between the
+    // hyperthreads of a core, L3 between the cpus of a socket, of which
+    // the T workers own their part (the packed B panel is shared by them)
+    const long L1 = cache.L1.size / cache.L1.shared
+             , L2 = cache.L2.size / cache.L2.shared
+             , L3 = cache.L3.size / cache.L3.shared * std::min(T, cache.L3.shared);
+
+    // B micro-panel (mK x NR) sized by L1, A block (mM x mK) by L2, B panel (mK x mN) by L3;
+    // only the last block along each dimension may be ragged
+    int mK = std::max(1L, std::min<long>(tuned.mK ? tuned.mK           : L1 / 4 / NR,            K));
+    int mM = std::max(1L, std::min<long>(tuned.mM ? tuned.mM / MR * MR : L2 / 4 / mK / MR * MR, M));
+    int mN = std::max(1L, std::min<long>(tuned.mN ? tuned.mN / NR * NR : L3 / 4 / mK / NR * NR, N));
+
+    int tM = std::min(T, (M + mM - 1) / mM);
+    if (tuned.tM > 0)
+        tM = std::min(tM, tuned.tM);
+    int tN = std::max(1, T / std::max(1, tM));
+
+    return { mK, mM, mN, std::max(1, tM), tN, &ker };
+}
+
+blocking_t make_blocking(int M, int N, int K, int threads, const kernel_t & ker, const cache_t & cache)
+{
+    // the profile applies only to the kernel it was tuned for
+    const profile_t & p = profile();
+    return make_blocking(M, N, K, threads, ker, cache, p.kernel == ker.name ? p : profile_t{});
+}
+
+blocking_t make_blocking(int M, int N, int K, int threads, const kernel_t & ker)
+{
+    return make_blocking(M, N, K, threads, ker, caches());
+}
+
+// packing buffers for one blocking: B panel (mN x mK) and one A block (mM x mK)
+int bufB_size(const blocking_t & b) { return (b.mN + b.ker->NR - 1) / b.ker->NR * b.ker->NR * b.mK; }
+int bufA_size(const blocking_t & b) { return (b.mM + b.ker->MR - 1) / b.ker->MR * b.ker->MR * b.mK; }
+
+std::ostream & operator<<(std::ostream & os, const blocking_t & b)
+{
+    return os << b.ker->name << " " << b.ker->MR << "x" << b.ker->NR
+              << " mK " << b.mK << " mM " << b.mM << " mN " << b.mN
+              << " threads " << b.tM << "x" << b.tN;
+}
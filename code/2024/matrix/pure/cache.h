@@ -0,0 +1,143 @@
+#pragma once
+#include <cpuid.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <string>
+
+// Data cache of one level as seen by one logical cpu
+struct level_t
+{
+    int size;   // bytes, 0 if the level is absent
+    int shared; // logical cpus sharing it
+};
+
+struct cache_t
+{
+    level_t L1, L2, L3;
+    const char * source; // "sysfs", "cpuid" or "default"
+};
+
+namespace detail
+{
+
+int parse_size(const std::string & s) // "48K", "2048K", "30M"
+{
+    int n = std::atoi(s.c_str());
+    switch (s.empty() ? ' ' : s.back())
+    {
+        case 'K': return n * 1024;
+        case 'M': return n * 1024 * 1024;
+        default : return n;
+    }
+}
+
+int count_cpus(const std::string & list) // "0-3,8-11" -> 8
+{
+    int n = 0;
+    for (size_t i = 0; i < list.size(); )
+    {
+        size_t end = list.find(',', i);
+        if (end == std::string::npos)
+            end = list.size();
+
+        std::string range = list.substr(i, end - i);
+        size_t dash = range.find('-');
+        n += dash == std::string::npos ? 1 : std::atoi(range.c_str() + dash + 1) - std::atoi(range.c_str()) + 1;
+
+        i = end + 1;
+    }
+    return std::max(1, n);
+}
+
+bool from_sysfs(cache_t & c)
+{
+    bool found = false;
+    for (int index = 0; ; ++index)
+    {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+
+        std::ifstream level(dir + "level"), type(dir + "type"), size(dir + "size"), shared(dir + "shared_cpu_list");
+        if (!level || !type || !size)
+            break;
+
+        int l; std::string t, s, list;
+        level >> l; type >> t; size >> s; shared >> list;
+        if (t == "Instruction")
+            continue;
+
+        level_t x = { parse_size(s), list.empty() ? 1 : count_cpus(list) };
+        if (l == 1) c.L1 = x;
+        if (l == 2) c.L2 = x;
+        if (l == 3) c.L3 = x;
+        found = true;
+    }
+    return found;
+}
+
+bool from_cpuid(cache_t & c)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    // deterministic cache parameters: leaf 4 on Intel, 0x8000001D on AMD
+    for (unsigned int leaf : { 4u, 0x8000001Du })
+    {
+        if (leaf > __get_cpuid_max(leaf & 0x80000000u, nullptr))
+            continue;
+
+        bool found = false;
+        for (unsigned int index = 0; __get_cpuid_count(leaf, index, &eax, &ebx, &ecx, &edx); ++index)
+        {
+            unsigned int type = eax & 0x1f; // 0 - no more caches, 1 - data, 2 - instruction, 3 - unified
+            if (type == 0)
+                break;
+            if (type == 2)
+                continue;
+
+            int l      = (eax >> 5) & 0x7;
+            int shared = ((eax >> 14) & 0xfff) + 1;
+            int size   = (((ebx >> 22) & 0x3ff) + 1)  // ways
+                       * (((ebx >> 12) & 0x3ff) + 1)  // partitions
+                       * (( ebx        & 0xfff) + 1)  // line size
+                       * (  ecx                 + 1); // sets
+
+            level_t x = { size, shared };
+            if (l == 1) c.L1 = x;
+            if (l == 2) c.L2 = x;
+            if (l == 3) c.L3 = x;
+            found = true;
+        }
+        if (found)
+            return true;
+    }
+    return false;
+}
+
+} // namespace detail
+
+// detected once; sizes the old hard-coded constants are used for missing levels
+const cache_t & caches()
+{
+    static const cache_t detected = []
+    {
+        cache_t c = {};
+        c.source = detail::from_sysfs(c) ? "sysfs"
+                 : detail::from_cpuid(c) ? "cpuid"
+                 :                         "default";
+
+        if (c.L1.size <= 0) c.L1 = {       32 * 1024, 1 };
+        if (c.L2.size <= 0) c.L2 = {      256 * 1024, 1 };
+        if (c.L3.size <= 0) c.L3 = { 2 * 1024 * 1024, 1 };
+        return c;
+    }();
+    return detected;
+}
+
+std::ostream & operator<<(std::ostream & os, const cache_t & c)
+{
+    return os << "L1 " << c.L1.size / 1024 << "K/" << c.L1.shared
+              << " L2 " << c.L2.size / 1024 << "K/" << c.L2.shared
+              << " L3 " << c.L3.size / 1024 << "K/" << c.L3.shared
+              << " (" << c.source << ")";
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <complex>
+#include <vector>
+
+// CGEMM by the 3M method: with A = Ar + i Ai, B = Br + i Bi,
+//   T1 = Ar Br, T2 = Ai Bi, T3 = (Ar + Ai)(Br + Bi), C = T1 - T2 + i (T3 - T1 - T2),
+// three real products instead of four. The packers split the interleaved input into the three
+// real operands of each block, side by side in bufA / bufB, through the kernel's own packer;
+// every tile runs the micro-kernel three times into local tiles and the recombination,
+// with alpha, is fused into the store of C, re-interleaved in registers. The imaginary part carries a slightly larger
+// error than the 4M product (it is a difference of products of sums)
+
+using cfloat = std::complex<float>;
+
+namespace detail
+{
+
+// rows [r0, r0 + dR) x columns [c0, c0 + dC) of op(X), as real, imaginary and real + imaginary, dR x dC each
+void split_3m( char trans, const cfloat * X, int ldx, int r0, int dR, int c0, int dC
+             , float * re, float * im, float * sum
+             )
+{
+    const bool  t = is_trans(trans);
+    const float s = trans == 'C' || trans == 'c' ? -1.f : 1.f; // conjugate
+
+    for (int r = 0; r < dR; ++r)
+        for (int c = 0; c < dC; ++c)
+        {
+            const cfloat x = t ? X[long(c0 + c) * ldx + r0 + r] : X[long(r0 + r) * ldx + c0 + c];
+            const int    e = r * dC + c;
+
+            re [e] = x.real();
+            im [e] = s * x.imag();
+            sum[e] = re[e] + im[e];
+        }
+}
+
+// C += alpha (T1 - T2 + i (T3 - T1 - T2)) for a dR x dC tile, T1..T3 are dR x ldt, plane floats apart
+void store_3m_generic(int dR, int dC, const float * t, int ldt, int plane, float ar, float ai, cfloat * C, int ldc)
+{
+    for (int r = 0; r < dR; ++r, t += ldt)
+    {
+        float * pC = reinterpret_cast<float *>(C + long(r) * ldc);
+        const float * t1 = t, * t2 = t + plane, * t3 = t + 2 * plane;
+
+        for (int c = 0; c < dC; ++c)
+        {
+            const float re = t1[c] - t2[c], im = t3[c] - t1[c] - t2[c];
+            pC[2 * c + 0] += ar * re - ai * im;
+            pC[2 * c + 1] += ar * im + ai * re;
+        }
+    }
+}
+
+AVX2 void store_3m(int dR, int dC, const float * t, int ldt, int plane, float ar, float ai, cfloat * C, int ldc)
+{
+    const __m256 a_r = _mm256_set1_ps(ar), a_i = _mm256_set1_ps(ai);
+
+    for (int r = 0; r < dR; ++r, t += ldt)
+    {
+        float * pC = reinterpret_cast<float *>(C + long(r) * ldc);
+        const float * t1 = t, * t2 = t + plane, * t3 = t + 2 * plane;
+
+        for (int c = 0; c < dC; c += 8) // 8 complex: two vectors of interleaved C
+        {
+            const __m256 x1 = _mm256_loadu_ps(t1 + c), x2 = _mm256_loadu_ps(t2 + c), x3 = _mm256_loadu_ps(t3 + c);
+            const __m256 re = _mm256_sub_ps(x1, x2);
+            const __m256 im = _mm256_sub_ps(_mm256_sub_ps(x3, x1), x2);
+
+            const __m256 cr = _mm256_fmsub_ps(a_r, re, _mm256_mul_ps(a_i, im));
+            const __m256 ci = _mm256_fmadd_ps(a_r, im, _mm256_mul_ps(a_i, re));
+
+            const __m256 lo = _mm256_unpacklo_ps(cr, ci), hi = _mm256_unpackhi_ps(cr, ci); // r0 i0 r1 i1 | r4 i4 r5 i5 ...
+            const __m256 o0 = _mm256_permute2f128_ps(lo, hi, 0x20), o1 = _mm256_permute2f128_ps(lo, hi, 0x31);
+
+            const __m256i m0 = mask_8(2 * (dC - c) - 0), m1 = mask_8(2 * (dC - c) - 8);
+            _mm256_maskstore_ps(pC + 2 * c + 0, m0, _mm256_add_ps(o0, _mm256_maskload_ps(pC + 2 * c + 0, m0)));
+            _mm256_maskstore_ps(pC + 2 * c + 8, m1, _mm256_add_ps(o1, _mm256_maskload_ps(pC + 2 * c + 8, m1)));
+        }
+    }
+}
+
+} // namespace detail
+
+// Row-major BLAS cgemm: C = alpha * op(A) * op(B) + beta * C, op is 'N', 'T' or 'C' (conjugate transpose),
+// leading dimensions in complex elements
+void cgemm( char transA, char transB, int M, int N, int K
+          , cfloat alpha, const cfloat * A, int lda
+          ,               const cfloat * B, int ldb
+          , cfloat beta ,       cfloat * C, int ldc
+          , ThreadPool * pool = nullptr
+          )
+{
+    if (M <= 0 || N <= 0)
+        return;
+
+    for (int i = 0; i < M; ++i)
+        for (int j = 0; j < N; ++j)
+            C[long(i) * ldc + j] = beta == 0.f ? cfloat(0.f) : beta * C[long(i) * ldc + j];
+    if (K <= 0 || alpha == 0.f)
+        return;
+
+    const kernel_t & ker = kernel();
+    const int   MR = ker.MR, NR = ker.NR;
+    const float ar = alpha.real(), ai = alpha.imag();
+
+    static const bool avx2 = find_kernel("avx2") != nullptr;
+
+    // three operands share the A block in L2 and the B panel in L3: a third of mM and mN each;
+    // K stays whole, a third of it would triple the passes of the store over C
+    blocking_t blocking = make_blocking(M, N, K, pool ? pool->size() : 1, ker);
+    blocking.mM = std::max(MR, blocking.mM / 3 / MR * MR);
+    blocking.mN = std::max(NR, blocking.mN / 3 / NR * NR);
+
+    std::vector<float> splitB(3 * std::size_t(blocking.mK) * NR); // B is packed serially, one split will do
+
+    detail::blocked
+    (
+        blocking, M, N, K,
+        [&](int i, int k, int dM, int dK, float * buf) // per micro-panel of A: Ar | Ai | Ar + Ai
+        {
+            float * re = buf + 3 * bufA_size(blocking), * im = re + MR * dK, * sum = im + MR * dK; // the task's scratch
+
+            for (int p = 0; p < dM; p += MR, buf += 3 * MR * dK)
+            {
+                const int dP = std::min(MR, dM - p);
+                detail::split_3m(transA, A, lda, i + p, dP, k, dK, re, im, sum);
+
+                ker.pack_a('N', re , dK, dP, dK, 1.f, buf);
+                ker.pack_a('N', im , dK, dP, dK, 1.f, buf + MR * dK);
+                ker.pack_a('N', sum, dK, dP, dK, 1.f, buf + 2 * MR * dK);
+            }
+        },
+        [&](int k, int j, int dK, int dN, float * buf) // per micro-panel of B: Br | Bi | Br + Bi
+        {
+            float * re = splitB.data(), * im = re + dK * dN, * sum = im + dK * dN;
+            detail::split_3m(transB, B, ldb, k, dK, j, dN, re, im, sum);
+
+            ker.pack_b('N', dK, dN, re , dN, buf);
+            ker.pack_b('N', dK, dN, im , dN, buf + dK * NR);
+            ker.pack_b('N', dK, dN, sum, dN, buf + 2 * dK * NR);
+        },
+        [](int, int, int, int) { return false; },
+        [&](int i, int dM, int j, int dN, int dK, const float * bufA, const float * bufB)
+        {
+            alignas(64) float t[3][16 * 32];
+
+            for (int jj = 0; jj < dN; jj += NR) // cycles 3 and 2
+                for (int ii = 0; ii < dM; ii += MR)
+                {
+                    const float * a = bufA + 3 * ii * dK, * b = bufB + 3 * jj * dK;
+                    std::fill_n(t[0], 3 * 16 * 32, 0.f);
+
+                    ker.micro(dK, a              , b              , t[0], NR); // T1 = Ar Br
+                    ker.micro(dK, a +     MR * dK, b +     NR * dK, t[1], NR); // T2 = Ai Bi
+                    ker.micro(dK, a + 2 * MR * dK, b + 2 * NR * dK, t[2], NR); // T3 = (Ar + Ai)(Br + Bi)
+
+                    const int dR = std::min(MR, dM - ii), dC = std::min(NR, dN - jj);
+                    (avx2 ? detail::store_3m : detail::store_3m_generic)(dR, dC, t[0], NR, 16 * 32, ar, ai, C + long(i + ii) * ldc + j + jj, ldc);
+                }
+        },
+        pool,
+        3,
+        3 * MR * blocking.mK
+    );
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <vector>
+
+// 2D convolution as an implicit GEMM: the im2col matrix is never formed, its blocks are gathered
+// from the image by the packers, a few rows at a time, and handed to the kernel's own packer,
+// so the memory beyond input and output is the packing buffers of the sgemm.
+// NHWC (weights R x S x C x K): C = patches * W, a row per output pixel, gathered for bufA;
+// NCHW (weights K x C x R x S): C = W * patches^T per image, a column per pixel, gathered for bufB
+
+struct conv_t
+{
+    int C, H, W; // input channels, height, width
+    int K, R, S; // output channels, filter height, width
+    int stride = 1, pad = 0;
+
+    int P() const { return (H + 2 * pad - R) / stride + 1; } // output height
+    int Q() const { return (W + 2 * pad - S) / stride + 1; } // output width
+};
+
+namespace detail
+{
+
+// row m (an output pixel of image n = m / (P Q)) of the NHWC im2col, columns [k, k + dK), k = (r, s, c)
+void gather_nhwc(const conv_t & cv, const float * x, int m, int k, int dK, float * row)
+{
+    const int PQ = cv.P() * cv.Q();
+    const int n  = m / PQ, p = m % PQ / cv.Q(), q = m % cv.Q();
+
+    int c = k % cv.C, s = k / cv.C % cv.S, r = k / cv.C / cv.S;
+    for (int e = 0; e < dK; ) // a run of channels at a time, contiguous in x
+    {
+        const int len = std::min(cv.C - c, dK - e);
+        const int h = p * cv.stride - cv.pad + r, w = q * cv.stride - cv.pad + s;
+
+        if (h < 0 || h >= cv.H || w < 0 || w >= cv.W)
+            std::fill(row + e, row + e + len, 0.f);
+        else
+            std::copy_n(x + ((long(n) * cv.H + h) * cv.W + w) * cv.C + c, len, row + e);
+
+        e += len;
+        c = 0;
+        if (++s == cv.S)
+            s = 0, ++r;
+    }
+}
+
+// rows [k, k + dK), k = (c, r, s), x columns [j, j + dN) (output pixels) of the im2col^T of one NCHW image;
+// a row is gathered by runs along the output rows, each a strided (contiguous for stride 1) read of x
+void gather_nchw(const conv_t & cv, const float * x, int k, int dK, int j, int dN, float * tile, int ldt)
+{
+    const int Q = cv.Q(), st = cv.stride;
+
+    for (int e = 0; e < dK; ++e, tile += ldt)
+    {
+        const int kk = k + e;
+        const int c = kk / (cv.R * cv.S), r = kk / cv.S % cv.R, s = kk % cv.S;
+        const float * xc = x + long(c) * cv.H * cv.W;
+
+        // q with 0 <= q * st - pad + s < W
+        const int qlo = std::max(0, (cv.pad - s + st - 1) / st);
+        const int qhi = std::min(Q, (cv.W + cv.pad - s + st - 1) / st);
+
+        for (int f = 0, p = j / Q, q0 = j % Q; f < dN; ++p, q0 = 0)
+        {
+            const int len = std::min(Q - q0, dN - f); // [q0, q0 + len) of output row p
+            const int h   = p * st - cv.pad + r;
+            float * t = tile + f - q0;
+
+            if (h < 0 || h >= cv.H)
+                std::fill(t + q0, t + q0 + len, 0.f);
+            else
+            {
+                const int a = std::clamp(qlo, q0, q0 + len), b = std::clamp(qhi, a, q0 + len);
+                const float * xr = xc + h * cv.W - cv.pad + s;
+
+                std::fill(t + q0, t + a, 0.f);
+                if (st == 1)
+                    std::copy(xr + a, xr + b, t + a);
+                else
+                    for (int q = a; q < b; ++q)
+                        t[q] = xr[q * st];
+                std::fill(t + b, t + q0 + len, 0.f);
+            }
+            f += len;
+        }
+    }
+}
+
+} // namespace detail
+
+// y (N x P x Q x K) = conv(x (N x H x W x C), w (R x S x C x K))
+void sconv_nhwc(int N, const conv_t & cv, const float * x, const float * w, float * y, ThreadPool * pool = nullptr)
+{
+    const int M = N * cv.P() * cv.Q(), Nc = cv.K, K = cv.R * cv.S * cv.C;
+    if (M <= 0 || Nc <= 0)
+        return;
+
+    const kernel_t & ker = kernel();
+    const blocking_t blocking = make_blocking(M, Nc, K, pool ? pool->size() : 1, ker);
+    ker.init_c(M, Nc, y, Nc, 0.f);
+
+    detail::blocked
+    (
+        blocking, M, Nc, K,
+        [&](int i, int k, int dM, int dK, float * buf) // implicit im2col: MR patches, then the kernel's packer
+        {
+            float * rows = buf + bufA_size(blocking); // the task's scratch
+
+            for (int p = 0; p < dM; p += ker.MR)
+            {
+                const int dP = std::min(ker.MR, dM - p);
+                for (int r = 0; r < dP; ++r)
+                    detail::gather_nhwc(cv, x, i + p + r, k, dK, rows + r * dK);
+
+                ker.pack_a('N', rows, dK, dP, dK, 1.f, buf + p * dK);
+            }
+        },
+        [&](int k, int j, int dK, int dN, float * buf)
+        {
+            ker.pack_b('N', dK, dN, w + long(k) * Nc + j, Nc, buf);
+        },
+        [](int, int, int, int) { return false; },
+        [&](int i, int dM, int j, int dN, int dK, const float * bufA, float * bufB)
+        {
+            macro(ker, dM, dN, dK, bufA, 'N', nullptr, 0, bufB, false, y + long(i) * Nc + j, Nc);
+        },
+        pool,
+        1,
+        ker.MR * blocking.mK
+    );
+}
+
+// y (N x K x P x Q) = conv(x (N x C x H x W), w (K x C x R x S)), one implicit GEMM per image
+void sconv_nchw(int N, const conv_t & cv, const float * x, const float * w, float * y, ThreadPool * pool = nullptr)
+{
+    const int M = cv.K, Np = cv.P() * cv.Q(), K = cv.C * cv.R * cv.S;
+    if (M <= 0 || Np <= 0)
+        return;
+
+    const kernel_t & ker = kernel();
+    const blocking_t blocking = make_blocking(M, Np, K, pool ? pool->size() : 1, ker);
+    std::vector<float> tile(std::size_t(blocking.mK) * ker.NR); // B is packed serially, one tile will do
+
+    for (int n = 0; n < N; ++n)
+    {
+        const float * xn = x + long(n) * cv.C * cv.H * cv.W;
+        float       * yn = y + long(n) * M * Np;
+        ker.init_c(M, Np, yn, Np, 0.f);
+
+        detail::blocked
+        (
+            blocking, M, Np, K,
+            [&](int i, int k, int dM, int dK, float * buf)
+            {
+                ker.pack_a('N', w + long(i) * K + k, K, dM, dK, 1.f, buf);
+            },
+            [&](int k, int j, int dK, int dN, float * buf) // implicit im2col: a micro-panel of patches, then the kernel's packer
+            {
+                detail::gather_nchw(cv, xn, k, dK, j, dN, tile.data(), ker.NR);
+                ker.pack_b('N', dK, dN, tile.data(), ker.NR, buf);
+            },
+            [](int, int, int, int) { return false; },
+            [&](int i, int dM, int j, int dN, int dK, const float * bufA, float * bufB)
+            {
+                macro(ker, dM, dN, dK, bufA, 'N', nullptr, 0, bufB, false, yn + long(i) * Np + j, Np);
+            },
+            pool
+        );
+    }
+}
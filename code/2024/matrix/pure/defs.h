@@ -6,20 +6,105 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <utility>
+
+class ThreadPool;
 
 typedef void (*gemm_t)(int M, int N, int K, const float * A, const float * B, float * C);
         void   gemm   (int M, int N, int K, const float * A, const float * B, float * C);
+        void   gemm   (int M, int N, int K, const float * A, const float * B, float * C, ThreadPool & pool);
+
+// Row-major BLAS sgemm: C = alpha * op(A) * op(B) + beta * C,
+// op(X) = X for trans == 'N', X^T for 'T' (or 'C'); op(A) is M x K, op(B) is K x N
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          );
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , ThreadPool & pool
+          );
+
+// Kernels are compiled for their own ISA and picked at run time (see dispatch.h),
+// so the rest of the library builds for the baseline target
+#define AVX2   __attribute__((target("avx2,fma")))
+#define AVX512 __attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,avx2,fma")))
+#define F16C   __attribute__((target("avx2,fma,f16c")))
+#define AVX512VNNI __attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,avx512vnni,avx2,fma")))
+
+// One register-blocked micro-kernel with matching packers:
+// packed A is MR x K panels (MR floats per k), packed B is K x NR panels (NR floats per k)
+struct kernel_t
+{
+    const char * name;
+    int MR, NR;
+
+    void (*micro     )(              int K, const float * A, const float * B, float * C, int ldc); // C += A * B, MR x NR
+    void (*micro_tail)(int M, int N, int K, const float * A, const float * B, float * C, int ldc); // M <= MR, N <= NR
+
+    void (*pack_a)(char trans, const float * A, int lda, int M, int K, float alpha, float * bufA);
+    void (*pack_b)(char trans, int K, int N, const float * B, int ldb, float * bufB); // one micro-panel, N <= NR
+    void (*init_c)(int M, int N, float * C, int ldc, float beta);
+    void (*add_c )(int M, int N, const float * P, int ldp, float * C, int ldc); // C += P
+};
+
+const kernel_t & kernel();                          // best one for this CPU, chosen once
+const kernel_t * find_kernel(const std::string & name); // nullptr if unknown or unsupported
+
+struct blocking_t
+{
+    int mK, mM, mN; // cache blocks: K in L1, M in L2, N in L3
+    int tM, tN;     // thread grid over cycle 4 (M panels) and cycle 3 (micro-panels of B)
+    const kernel_t * ker;
+};
 
-void micro_6x16( int K, int step
-               , const float * A, int lda
-               , const float * B, int ldb
-               ,       float * C, int ldc
-               );
+struct cache_t;
+struct profile_t;
 
-void init_c(int M, int N, float * C, int ldc);
+// block sizes from the detected caches (see cache.h), overridden by the loaded profile (see profile.h)
+blocking_t make_blocking(int M, int N, int K, int threads, const kernel_t & ker = kernel());
+blocking_t make_blocking(int M, int N, int K, int threads, const kernel_t & ker, const cache_t & cache);
+blocking_t make_blocking(int M, int N, int K, int threads, const kernel_t & ker, const cache_t & cache, const profile_t & tuned);
 
-void reorder_b_16(const float * B, int ldb,        int K, float *   _B);
-void reorder_a_6 (const float * A, int lda, int M, int K, float * bufA);
+AVX2 void micro_6x16( int K, int step
+                    , const float * A, int lda
+                    , const float * B, int ldb
+                    ,       float * C, int ldc
+                    );
+AVX2 void micro_6x16_tail( int M, int N, int K
+                         , const float * A
+                         , const float * B
+                         ,       float * C, int ldc
+                         );
+
+AVX2 void init_c(int M, int N, float * C, int ldc, float beta = 0.f);
+AVX2 void add_c (int M, int N, const float * P, int ldp, float * C, int ldc);
+
+AVX2 void reorder_b_16     (int K,        const float * B, int ldb, float * bufB);
+AVX2 void reorder_b_16_tail(int K, int N, const float * B, int ldb, float * bufB);
+AVX2 void reorder_b_16_t   (int K, int N, const float * B, int ldb, float * bufB);
+AVX2 void reorder_a_6      (const float * A, int lda, int M, int K, float * bufA, float alpha = 1.f);
+AVX2 void reorder_a_6_t    (const float * A, int lda, int M, int K, float * bufA, float alpha = 1.f);
+
+inline bool is_trans(char trans)
+{
+    return trans == 'T' || trans == 't' || trans == 'C' || trans == 'c';
+}
+
+// address of element (r, c) of op(X) stored with leading dimension ld
+inline const float * at(char trans, const float * X, int ld, int r, int c)
+{
+    return is_trans(trans) ? X + c * ld + r : X + r * ld + c;
+}
+
+// lanes [0, n) are set, the rest are cleared; n may be out of [0, 8]
+AVX2 inline __m256i mask_8(int n)
+{
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
 
 struct buf_t
 {
@@ -28,9 +113,27 @@ struct buf_t
 
     buf_t(int size) 
     : 
-        n(size), 
-        p((float*)_mm_malloc(size * 4, 64)) 
+        p((float*)_mm_malloc(size * 4, 64)), 
+        n(size) 
+    {}
+
+    buf_t(buf_t && other) noexcept
+    :
+        p(std::exchange(other.p, nullptr)),
+        n(other.n)
     {}
 
+    buf_t(const buf_t &) = delete;
+
     ~buf_t() { _mm_free(p); }
 };
+
+// Single-threaded, on a caller-provided workspace, see gemm.h
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , const blocking_t & blocking
+          , buf_t & bufB
+          , buf_t & bufA
+          );
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdlib>
+
+const kernel_t kernels[] =
+{
+    {
+        "avx512", 14, 32,
+        micro_14x32,
+        micro_14x32_tail,
+        reorder_a_14,
+        reorder_b_32,
+        init_c,
+        add_c
+    },
+    {
+        "avx2", 6, 16,
+        [](int K, const float * A, const float * B, float * C, int ldc) { micro_6x16(K, 6, A, 1, B, 16, C, ldc); },
+        micro_6x16_tail,
+        reorder_a,
+        reorder_b,
+        init_c,
+        add_c
+    },
+    {
+        "scalar", 4, 8,
+        micro_generic<4, 8>,
+        micro_tail_generic<4, 8, micro_generic<4, 8>>,
+        pack_a_generic<4>,
+        pack_b_generic<8>,
+        init_c_generic,
+        add_c_generic
+    },
+};
+
+bool supported(const kernel_t & ker)
+{
+    __builtin_cpu_init();
+
+    std::string name = ker.name;
+    if (name == "avx512")
+        return __builtin_cpu_supports("avx512f")
+            && __builtin_cpu_supports("avx512vl")
+            && __builtin_cpu_supports("avx512bw")
+            && __builtin_cpu_supports("avx512dq");
+    if (name == "avx2")
+        return __builtin_cpu_supports("avx2")
+            && __builtin_cpu_supports("fma");
+    return true;
+}
+
+const kernel_t * find_kernel(const std::string & name)
+{
+    for (const kernel_t & ker : kernels)
+        if (name == ker.name)
+            return supported(ker) ? &ker : nullptr;
+    return nullptr;
+}
+
+// kernels are ordered best first; GEMM_KERNEL=<name>, then the profile, may force a supported one
+const kernel_t & kernel()
+{
+    static const kernel_t & selected = []() -> const kernel_t &
+    {
+        if (const char * env = std::getenv("GEMM_KERNEL"))
+            if (const kernel_t * ker = find_kernel(env))
+                return *ker;
+
+        if (const kernel_t * ker = find_kernel(profile().kernel))
+            return *ker;
+
+        for (const kernel_t & ker : kernels)
+            if (supported(ker))
+                return ker;
+        return kernels[std::size(kernels) - 1];
+    }();
+    return selected;
+}
+
+template<typename Epi>
+using micro_epi_t = void (*)(int K, const float * A, const float * B, float * C, int ldc, const Epi & epi, int i, int j);
+
+// the kernel's micro with the epilogue fused into its store, nullptr if it has none
+template<typename Epi>
+micro_epi_t<Epi> micro_epi(const kernel_t & ker)
+{
+    std::string name = ker.name;
+    if (name == "avx512")
+        return micro_14x32<Epi>;
+    if (name == "avx2")
+        return [](int K, const float * A, const float * B, float * C, int ldc, const Epi & epi, int i, int j) { micro_6x16(K, 6, A, 1, B, 16, C, ldc, epi, i, j); };
+    return nullptr;
+}
@@ -0,0 +1,268 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <string_view>
+#include <vector>
+
+// Tensor contraction from an einsum spec over strided views, e.g. "bhqd,bhkd->bhqk":
+// C = alpha * sum over the indices not in C of A * B + beta * C. The indices are grouped as
+// batch (in A, B and C), M (A and C), N (B and C) and K (A and B); an index of one input only is
+// a K index with stride 0 in the other, one of C only an M index with stride 0 in A. Within a group,
+// the indices that are contiguous in every operand merge into one, the innermost of them is the
+// GEMM dimension and the others, like the batch, are looped over, so nothing is permuted in memory:
+// with a unit stride on either side of A and B the slice is an sgemm with trans flags,
+// otherwise the kernel's packers are fed through a strided gather. C needs a unit stride on one
+// side (a column-major C is the transposed problem), or a slice goes through a temporary
+
+template<typename T>
+struct view_t // element (i0, i1, ...) at data[i0 * stride[0] + i1 * stride[1] + ...]
+{
+    T * data;
+    std::vector<int>  shape;
+    std::vector<long> stride;
+
+    operator view_t<const T>() const { return { data, shape, stride }; }
+};
+
+// a contiguous row-major tensor
+template<typename T>
+view_t<T> make_view(T * data, std::vector<int> shape)
+{
+    std::vector<long> stride(shape.size());
+    for (long s = 1, d = long(shape.size()) - 1; d >= 0; s *= shape[d--])
+        stride[d] = s;
+    return { data, std::move(shape), std::move(stride) };
+}
+
+namespace detail
+{
+
+struct dim_t
+{
+    int  n;
+    long a, b, c; // strides in A, B, C
+};
+
+// drops extent 1, orders by the key stride, outermost first, and merges dims that are one in every operand
+std::vector<dim_t> merge_dims(std::vector<dim_t> dims, long dim_t::* key)
+{
+    std::erase_if(dims, [](const dim_t & d) { return d.n == 1; });
+    std::stable_sort(dims.begin(), dims.end(), [&](const dim_t & x, const dim_t & y) { return x.*key > y.*key; });
+
+    std::vector<dim_t> out;
+    for (const dim_t & d : dims)
+    {
+        if (!out.empty())
+        {
+            dim_t & o = out.back();
+            if (o.a == d.a * d.n && o.b == d.b * d.n && o.c == d.c * d.n)
+            {
+                o = { o.n * d.n, d.a, d.b, d.c };
+                continue;
+            }
+        }
+        out.push_back(d);
+    }
+    return out;
+}
+
+// packs rows [0, dM) x [0, dK) of A, element (i, k) at A[i * sM + k * sK], as the kernel's packer would
+void pack_a_strided(const kernel_t & ker, const float * A, long sM, long sK, int dM, int dK, float alpha, float * buf)
+{
+    if (sK == 1)
+        return ker.pack_a('N', A, int(sM), dM, dK, alpha, buf);
+    if (sM == 1)
+        return ker.pack_a('T', A, int(sK), dM, dK, alpha, buf);
+
+    const int MR = ker.MR;
+    for (int i = 0; i < dM; i += MR)
+    {
+        const int dP = std::min(MR, dM - i);
+        for (int k = 0; k < dK; ++k, buf += MR)
+            for (int r = 0; r < MR; ++r)
+                buf[r] = r < dP ? alpha * A[(i + r) * sM + k * sK] : 0.f;
+    }
+}
+
+// one micro-panel, dN <= NR, element (k, j) at B[k * sK + j * sN]
+void pack_b_strided(const kernel_t & ker, const float * B, long sK, long sN, int dK, int dN, float * buf)
+{
+    if (sN == 1)
+        return ker.pack_b('N', dK, dN, B, int(sK), buf);
+    if (sK == 1)
+        return ker.pack_b('T', dK, dN, B, int(sN), buf);
+
+    const int NR = ker.NR;
+    for (int k = 0; k < dK; ++k, buf += NR)
+        for (int c = 0; c < NR; ++c)
+            buf[c] = c < dN ? B[k * sK + c * sN] : 0.f;
+}
+
+// C (M x N, unit column stride) = alpha * A * B + beta * C over strided A and B
+void sgemm_strided( int M, int N, int K
+                  , float alpha, const float * A, long sAm, long sAk
+                  ,              const float * B, long sBk, long sBn
+                  , float beta ,       float * C, long sCm, long sCn
+                  , ThreadPool * pool
+                  )
+{
+    if (M <= 0 || N <= 0)
+        return;
+
+    if (sCn != 1 && (sCm == 1 || M == 1)) // C^T = B^T A^T
+        return sgemm_strided(N, M, K, alpha, B, sBn, sBk, A, sAk, sAm, beta, C, sCn, M == 1 ? 1 : sCm, pool);
+
+    if (sCn != 1 && N > 1) // no unit stride in C: through a row-major temporary
+    {
+        buf_t T(M * N);
+        sgemm_strided(M, N, K, alpha, A, sAm, sAk, B, sBk, sBn, 0.f, T.p, N, 1, pool);
+        for (int i = 0; i < M; ++i)
+            for (int j = 0; j < N; ++j)
+            {
+                float & c = C[i * sCm + j * sCn];
+                c = (beta == 0.f ? 0.f : beta * c) + T.p[i * N + j];
+            }
+        return;
+    }
+
+    // extent 1 leaves a stride free: unit, if it makes a side contiguous
+    if (M == 1) sAm = 1;
+    if (K == 1) sAk = sBk = 1;
+    if (N == 1) sBn = 1;
+
+    const char transA = sAk == 1 ? 'N' : sAm == 1 ? 'T' : 0;
+    const char transB = sBn == 1 ? 'N' : sBk == 1 ? 'T' : 0;
+    const long lda = transA == 'N' ? sAm : sAk, ldb = transB == 'N' ? sBk : sBn;
+
+    if (transA && transB && lda > 0 && ldb > 0) // the BLAS sgemm as is
+    {
+        if (pool)
+            return sgemm(transA, transB, M, N, K, alpha, A, int(lda), B, int(ldb), beta, C, int(sCm), *pool);
+        return sgemm(transA, transB, M, N, K, alpha, A, int(lda), B, int(ldb), beta, C, int(sCm));
+    }
+
+    const kernel_t & ker = kernel();
+    ker.init_c(M, N, C, int(sCm), beta);
+    if (K <= 0 || alpha == 0.f)
+        return;
+
+    detail::blocked
+    (
+        make_blocking(M, N, K, pool ? pool->size() : 1, ker), M, N, K,
+        [&](int i, int k, int dM, int dK, float * buf)
+        {
+            pack_a_strided(ker, A + i * sAm + k * sAk, sAm, sAk, dM, dK, alpha, buf);
+        },
+        [&](int k, int j, int dK, int dN, float * buf)
+        {
+            pack_b_strided(ker, B + k * sBk + j * sBn, sBk, sBn, dK, dN, buf);
+        },
+        [](int, int, int, int) { return false; },
+        [&](int i, int dM, int j, int dN, int dK, const float * bufA, float * bufB)
+        {
+            macro(ker, dM, dN, dK, bufA, 'N', nullptr, 0, bufB, false, C + i * sCm + j, int(sCm));
+        },
+        pool
+    );
+}
+
+// offsets of loop index t over dims, the first dim outermost
+dim_t offsets(const std::vector<dim_t> & dims, long t)
+{
+    dim_t o = { 0, 0, 0, 0 };
+    for (int d = int(dims.size()) - 1; d >= 0; t /= dims[d--].n)
+    {
+        const long x = t % dims[d].n;
+        o.a += x * dims[d].a, o.b += x * dims[d].b, o.c += x * dims[d].c;
+    }
+    return o;
+}
+
+} // namespace detail
+
+void einsum( std::string_view spec
+           , float alpha, const view_t<const float> & A, const view_t<const float> & B
+           , float beta , const view_t<float> & C
+           , ThreadPool * pool = nullptr
+           )
+{
+    using detail::dim_t;
+
+    const std::size_t comma = spec.find(','), arrow = spec.find("->");
+    assert(comma != spec.npos && arrow != spec.npos && comma < arrow);
+    const std::string_view sa = spec.substr(0, comma), sb = spec.substr(comma + 1, arrow - comma - 1), sc = spec.substr(arrow + 2);
+    assert(sa.size() == A.shape.size() && sb.size() == B.shape.size() && sc.size() == C.shape.size());
+
+    // every index once: extent and strides, 0 where it is absent
+    std::vector<dim_t> batch, dm, dn, dk;
+    std::string seen;
+    for (std::string_view s : { sa, sb, sc })
+        for (char x : s)
+        {
+            if (seen.find(x) != seen.npos)
+                continue;
+            seen += x;
+
+            const std::size_t ia = sa.find(x), ib = sb.find(x), ic = sc.find(x);
+            assert(sa.rfind(x) == ia && sb.rfind(x) == ib && sc.rfind(x) == ic); // no diagonals
+
+            dim_t d = { 0, 0, 0, 0 };
+            for (auto [i, v] : { std::pair(ia, &A.shape), std::pair(ib, &B.shape), std::pair(ic, &C.shape) })
+                if (i != std::string_view::npos)
+                {
+                    assert(d.n == 0 || d.n == (*v)[i]);
+                    d.n = (*v)[i];
+                }
+            if (ia != sa.npos) d.a = A.stride[ia];
+            if (ib != sb.npos) d.b = B.stride[ib];
+            if (ic != sc.npos) d.c = C.stride[ic];
+
+            const bool a = ia != sa.npos, b = ib != sb.npos, c = ic != sc.npos;
+            (a && b && c ? batch : c ? (b && !a ? dn : dm) : dk).push_back(d);
+        }
+
+    // the innermost merged dim of a group is the GEMM's, the rest are loops
+    auto gemm_dim = [](std::vector<dim_t> & loop, std::vector<dim_t> dims, long dim_t::* key)
+    {
+        dims = detail::merge_dims(std::move(dims), key);
+        const dim_t d = dims.empty() ? dim_t{ 1, 0, 0, 0 } : dims.back();
+        loop.insert(loop.end(), dims.begin(), dims.end() - !dims.empty());
+        return d;
+    };
+    std::vector<dim_t> outer = detail::merge_dims(batch, &dim_t::c), inner;
+    const dim_t m = gemm_dim(outer, dm, &dim_t::c);
+    const dim_t n = gemm_dim(outer, dn, &dim_t::c);
+    const dim_t k = gemm_dim(inner, dk, &dim_t::a);
+
+    long S = 1, R = 1; // independent slices of C; K slices summed into each
+    for (const dim_t & d : outer) S *= d.n;
+    for (const dim_t & d : inner) R *= d.n;
+
+    auto slice = [&](long s, ThreadPool * p)
+    {
+        const dim_t o = detail::offsets(outer, s);
+        for (long r = 0; r < R; ++r)
+        {
+            const dim_t q = detail::offsets(inner, r);
+            detail::sgemm_strided
+            (
+                m.n, n.n, k.n,
+                alpha, A.data + o.a + q.a, m.a, k.a,
+                       B.data + o.b + q.b, k.b, n.b,
+                r == 0 ? beta : 1.f, C.data + o.c, m.c, n.c,
+                p
+            );
+        }
+    };
+
+    // many slices: a share of them per thread; a few: the pool goes to each product
+    const int T = pool ? int(std::min<long>(pool->size(), S)) : 1;
+    if (T > 1 && S >= long(pool->size()))
+        detail::parallel_for(pool, T, [&](int t)
+        {
+            for (long s = S * t / T; s < S * (t + 1) / T; ++s)
+                slice(s, nullptr);
+        });
+    else
+        for (long s = 0; s < S; ++s)
+            slice(s, pool);
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <cmath>
+#include <type_traits>
+
+// Epilogues: a functor applied to finished elements of C right before they are stored,
+// in registers: x = alpha * op(A) * op(B) + beta * C at row i, columns [j, j + lanes).
+// Each one has a float overload (edges, scalar kernel) and the register types of the kernels.
+
+struct epi_none
+{
+           float  operator()( float x, int, int) const { return x; }
+    AVX2   __m256 operator()(__m256 x, int, int) const { return x; }
+    AVX512 __m512 operator()(__m512 x, int, int) const { return x; }
+};
+
+struct epi_scale // x * s
+{
+    float s;
+
+           float  operator()( float x, int, int) const { return x * s; }
+    AVX2   __m256 operator()(__m256 x, int, int) const { return _mm256_mul_ps(x, _mm256_set1_ps(s)); }
+    AVX512 __m512 operator()(__m512 x, int, int) const { return _mm512_mul_ps(x, _mm512_set1_ps(s)); }
+};
+
+struct epi_bias_row // x + b[i], b has M entries
+{
+    const float * b;
+
+           float  operator()( float x, int i, int) const { return x + b[i]; }
+    AVX2   __m256 operator()(__m256 x, int i, int) const { return _mm256_add_ps(x, _mm256_set1_ps(b[i])); }
+    AVX512 __m512 operator()(__m512 x, int i, int) const { return _mm512_add_ps(x, _mm512_set1_ps(b[i])); }
+};
+
+struct epi_bias_col // x + b[j], b has N entries
+{
+    const float * b;
+
+           float  operator()( float x, int, int j) const { return x + b[j]; }
+    AVX2   __m256 operator()(__m256 x, int, int j) const { return _mm256_add_ps(x, _mm256_loadu_ps(b + j)); }
+    AVX512 __m512 operator()(__m512 x, int, int j) const { return _mm512_add_ps(x, _mm512_loadu_ps(b + j)); }
+};
+
+struct epi_relu
+{
+           float  operator()( float x, int, int) const { return std::max(x, 0.f); }
+    AVX2   __m256 operator()(__m256 x, int, int) const { return _mm256_max_ps(x, _mm256_setzero_ps()); }
+    AVX512 __m512 operator()(__m512 x, int, int) const { return _mm512_max_ps(x, _mm512_setzero_ps()); }
+};
+
+struct epi_clamp // min(max(x, lo), hi)
+{
+    float lo, hi;
+
+           float  operator()( float x, int, int) const { return std::min(std::max(x, lo), hi); }
+    AVX2   __m256 operator()(__m256 x, int, int) const { return _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(lo)), _mm256_set1_ps(hi)); }
+    AVX512 __m512 operator()(__m512 x, int, int) const { return _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(lo)), _mm512_set1_ps(hi)); }
+};
+
+// e^x: x = n ln2 + r, e^r by the cephes polynomial, 2^n through the exponent bits
+AVX2 inline __m256 exp_8(__m256 x)
+{
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.3f)), _mm256_set1_ps(88.3f));
+
+    __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+           r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+
+    __m256 p =                 _mm256_set1_ps(1.9875691500e-4f);
+           p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.3981999507e-3f));
+           p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(8.3334519073e-3f));
+           p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(4.1665795894e-2f));
+           p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.6666665459e-1f));
+           p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(5.0000001201e-1f));
+           p = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1.f)));
+
+    __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(e));
+}
+
+AVX512 inline __m512 exp_16(__m512 x)
+{
+    x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(-87.3f)), _mm512_set1_ps(88.3f));
+
+    __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(1.44269504f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(0.693359375f), x);
+           r = _mm512_fnmadd_ps(n, _mm512_set1_ps(-2.12194440e-4f), r);
+
+    __m512 p =                 _mm512_set1_ps(1.9875691500e-4f);
+           p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.3981999507e-3f));
+           p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(8.3334519073e-3f));
+           p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(4.1665795894e-2f));
+           p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.6666665459e-1f));
+           p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(5.0000001201e-1f));
+           p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r), _mm512_add_ps(r, _mm512_set1_ps(1.f)));
+
+    __m512i e = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23);
+    return _mm512_mul_ps(p, _mm512_castsi512_ps(e));
+}
+
+struct epi_gelu // tanh form: 0.5 x (1 + tanh(y)) = x / (1 + e^(-2y)), y = sqrt(2/pi) (x + 0.044715 x^3)
+{
+    float operator()(float x, int, int) const
+    {
+        return x / (1.f + std::exp(-1.5957691f * (x + 0.044715f * x * x * x)));
+    }
+
+    AVX2 __m256 operator()(__m256 x, int, int) const
+    {
+        __m256 y = _mm256_mul_ps(_mm256_fmadd_ps(_mm256_mul_ps(x, x), _mm256_set1_ps(0.044715f), _mm256_set1_ps(1.f)), x);
+        __m256 e = exp_8(_mm256_mul_ps(y, _mm256_set1_ps(-1.5957691f)));
+        return _mm256_div_ps(x, _mm256_add_ps(e, _mm256_set1_ps(1.f)));
+    }
+
+    AVX512 __m512 operator()(__m512 x, int, int) const
+    {
+        __m512 y = _mm512_mul_ps(_mm512_fmadd_ps(_mm512_mul_ps(x, x), _mm512_set1_ps(0.044715f), _mm512_set1_ps(1.f)), x);
+        __m512 e = exp_16(_mm512_mul_ps(y, _mm512_set1_ps(-1.5957691f)));
+        return _mm512_div_ps(x, _mm512_add_ps(e, _mm512_set1_ps(1.f)));
+    }
+};
+
+// g(f(x)): e.g. epi_then<epi_bias_col, epi_gelu>{ { bias }, {} }
+template<typename F, typename G>
+struct epi_then
+{
+    F f;
+    G g;
+
+           float  operator()( float x, int i, int j) const { return g(f(x, i, j), i, j); }
+    AVX2   __m256 operator()(__m256 x, int i, int j) const { return g(f(x, i, j), i, j); }
+    AVX512 __m512 operator()(__m512 x, int i, int j) const { return g(f(x, i, j), i, j); }
+};
+
+template<typename F, typename G>
+epi_then<F, G> then(F f, G g) { return { f, g }; }
+
+// the epilogue over a whole block of C at row i0, column j0, for the paths that never reach a kernel
+template<typename Epi>
+void apply_epilogue(int M, int N, float * C, int ldc, const Epi & epi, int i0 = 0, int j0 = 0)
+{
+    if constexpr (std::is_same_v<Epi, epi_none>)
+        return;
+
+    for (int i = 0; i < M; ++i)
+        for (int j = 0; j < N; ++j)
+            C[i * ldc + j] = epi(C[i * ldc + j], i0 + i, j0 + j);
+}
@@ -0,0 +1,259 @@
+#pragma once
+#include "../tools/matrix.h"
+#include "../tools/threadpool.h"
+#include <optional>
+
+// Lazy expressions over Matrix<float>: products, sums, scaling by a float and trans() build nodes,
+// and alpha * op(A) * op(B) + beta * op(C) is matched at assignment into one sgemm, beta * C being
+// the destination itself when it can (in place for D = A * B + D and D += A * B) and a temporary
+// operand being moved into the result rather than copied:
+//   D = A * B + C;   D -= 2.f * trans(A) * B;   Matrix<float> E = A * trans(B) - D;
+// A product within a product is evaluated to a temporary first. Nodes hold references to named
+// operands and are consumed by assignment, so `auto e = A * B;` is to be moved into a matrix
+
+namespace expr
+{
+
+// a matrix, uninitialized, laid out as emptyMatrix(width, height, 64)
+Matrix<float> blank(std::size_t width, std::size_t height)
+{
+    const std::size_t memoryWidth = (width + 15) / 16 * 16;
+    float * memory = static_cast<float *>(std::aligned_alloc(64, std::max<std::size_t>(1, memoryWidth * height) * sizeof(float)));
+    return { .memory = { memory, {} }, .memoryWidth = memoryWidth, .width = width, .height = height };
+}
+
+struct node_t;
+
+// scale * op(X), X either named or a temporary owned by the term
+struct term_t
+{
+    const Matrix<float> * m;
+    Matrix<float> owned {};
+    char  trans = 'N';
+    float scale = 1.f;
+
+    term_t(const Matrix<float> & x) : m(&x) {}
+    term_t(Matrix<float> && x) : m(&owned), owned(std::move(x)) {}
+    term_t(node_t && e);
+    term_t(term_t && t) noexcept : m(t.m == &t.owned ? &owned : t.m), owned(std::move(t.owned)), trans(t.trans), scale(t.scale) {}
+    term_t & operator=(term_t &&) = delete;
+
+    std::size_t rows() const { return is_trans(trans) ? m->width  : m->height; }
+    std::size_t cols() const { return is_trans(trans) ? m->height : m->width;  }
+    bool temporary()   const { return m == &owned; }
+
+    void assign_to(Matrix<float> & D, ThreadPool * pool = nullptr) &&;
+    void add_to(Matrix<float> & D, float sign, ThreadPool * pool = nullptr) &&;
+    operator Matrix<float>() &&;
+};
+
+// D = gamma * D + s * op(X); untransposed it is one pass and X may be D itself
+void axpby(Matrix<float> & D, float gamma, const term_t & x, float s)
+{
+    const std::size_t M = D.height, N = D.width;
+
+    if (!is_trans(x.trans))
+    {
+        for (std::size_t i = 0; i < M; ++i)
+        {
+            float * d = D[i]; const float * a = (*x.m)[i];
+            if (gamma == 0.f)
+                for (std::size_t j = 0; j < N; ++j) d[j] = s * a[j];
+            else
+                for (std::size_t j = 0; j < N; ++j) d[j] = gamma * d[j] + s * a[j];
+        }
+        return;
+    }
+
+    assert(x.m != &D);
+    if (gamma == 0.f) // the transpose goes straight into D
+    {
+        transpose(int(x.m->height), int(x.m->width), x.m->memory.get(), long(x.m->memoryWidth), D.memory.get(), long(D.memoryWidth));
+        if (s != 1.f)
+            axpby(D, 0.f, term_t(D), s);
+    }
+    else
+        axpby(D, gamma, term_t(transpose(*x.m)), s);
+}
+
+// alpha * op(A) * op(B) + beta * op(C), without B it is alpha * op(A) + beta * op(C)
+struct node_t
+{
+    float alpha = 1.f;
+    term_t a;
+    std::optional<term_t> b {};
+    float beta = 0.f;
+    std::optional<term_t> c {};
+
+    explicit node_t(term_t && x) : alpha(x.scale), a(std::move(x)) { a.scale = 1.f; }
+    node_t(term_t && x, term_t && y) : alpha(x.scale * y.scale), a(std::move(x)), b(std::move(y)) { a.scale = b->scale = 1.f; }
+    node_t(node_t &&) = default;
+
+    std::size_t rows() const { return a.rows(); }
+    std::size_t cols() const { return b ? b->cols() : a.cols(); }
+
+    // something of D is read at another position than it is written at
+    bool aliases(const Matrix<float> & D) const
+    {
+        if (b)
+            return a.m == &D || b->m == &D || (c && c->m == &D && is_trans(c->trans));
+        return (a.m == &D && is_trans(a.trans)) || (c && c->m == &D && is_trans(c->trans));
+    }
+
+    // D = gamma * D + this, D of the right shape and not aliased
+    void run(Matrix<float> & D, float gamma, ThreadPool * pool)
+    {
+        const int M = int(rows()), N = int(cols());
+
+        if (c && !b && !is_trans(a.trans) && !is_trans(c->trans)) // a linear combination: one pass
+        {
+            const float sa = alpha * a.scale, sc = beta * c->scale;
+            for (int i = 0; i < M; ++i)
+            {
+                float * d = D[i]; const float * x = (*a.m)[i], * y = (*c->m)[i];
+                for (int j = 0; j < N; ++j)
+                    d[j] = (gamma == 0.f ? 0.f : gamma * d[j]) + sa * x[j] + sc * y[j];
+            }
+            return;
+        }
+
+        if (c && c->m == &D) // beta * C folds into the beta of sgemm
+            gamma += beta * c->scale;
+        else if (c)
+            axpby(D, gamma, *c, beta * c->scale), gamma = 1.f;
+
+        if (!b)
+            return axpby(D, gamma, a, alpha * a.scale);
+
+        const int K = int(a.cols());
+        assert(b->rows() == std::size_t(K));
+
+        const float s = alpha * a.scale * b->scale;
+        if (pool)
+            sgemm(a.trans, b->trans, M, N, K, s, a.m->memory.get(), int(a.m->memoryWidth), b->m->memory.get(), int(b->m->memoryWidth), gamma, D.memory.get(), int(D.memoryWidth), *pool);
+        else
+            sgemm(a.trans, b->trans, M, N, K, s, a.m->memory.get(), int(a.m->memoryWidth), b->m->memory.get(), int(b->m->memoryWidth), gamma, D.memory.get(), int(D.memoryWidth));
+    }
+
+    void assign_to(Matrix<float> & D, ThreadPool * pool = nullptr) &&
+    {
+        assert(!c || (c->rows() == rows() && c->cols() == cols()));
+
+        if (aliases(D))
+        {
+            Matrix<float> T = blank(cols(), rows());
+            run(T, 0.f, pool);
+            D = std::move(T);
+            return;
+        }
+
+        if (c && c->temporary() && !is_trans(c->trans) && a.m != &D) // C's storage becomes D's
+        {
+            D = std::move(c->owned);
+            c->m = &D;
+        }
+        else if (D.width != cols() || D.height != rows() || !D.memory)
+        {
+            assert(!c || c->m != &D);
+            D = blank(cols(), rows());
+        }
+        run(D, 0.f, pool);
+    }
+
+    void add_to(Matrix<float> & D, float sign, ThreadPool * pool = nullptr) &&
+    {
+        assert(D.width == cols() && D.height == rows());
+
+        if (aliases(D))
+            return term_t(std::move(*this).eval(pool)).add_to(D, sign, pool);
+
+        alpha *= sign, beta *= sign;
+        run(D, 1.f, pool);
+    }
+
+    Matrix<float> eval(ThreadPool * pool = nullptr) &&
+    {
+        Matrix<float> D {};
+        std::move(*this).assign_to(D, pool);
+        return D;
+    }
+
+    operator Matrix<float>() && { return std::move(*this).eval(); }
+};
+
+term_t::term_t(node_t && e) : term_t(std::move(e).eval()) {}
+
+void term_t::assign_to(Matrix<float> & D, ThreadPool * pool) && { node_t(std::move(*this)).assign_to(D, pool); }
+void term_t::add_to(Matrix<float> & D, float sign, ThreadPool * pool) && { node_t(std::move(*this)).add_to(D, sign, pool); }
+term_t::operator Matrix<float>() && { return node_t(std::move(*this)).eval(); }
+
+} // namespace expr
+
+expr::term_t trans(expr::term_t x)
+{
+    x.trans = is_trans(x.trans) ? 'N' : 'T';
+    return x;
+}
+
+// (alpha op(A) op(B) + beta op(C))^T = alpha op(B)^T op(A)^T + beta op(C)^T
+expr::node_t trans(expr::node_t e)
+{
+    if (e.b)
+    {
+        expr::node_t t(trans(std::move(*e.b)), trans(std::move(e.a)));
+        t.alpha = e.alpha;
+        t.beta  = e.beta;
+        if (e.c)
+            t.c.emplace(trans(std::move(*e.c)));
+        return t;
+    }
+    e.a.trans = is_trans(e.a.trans) ? 'N' : 'T';
+    if (e.c)
+        e.c->trans = is_trans(e.c->trans) ? 'N' : 'T';
+    return e;
+}
+
+expr::term_t operator*(float s, expr::term_t x) { x.scale *= s; return x; }
+expr::term_t operator*(expr::term_t x, float s) { x.scale *= s; return x; }
+expr::term_t operator-(expr::term_t x)          { x.scale = -x.scale; return x; }
+
+expr::node_t operator*(float s, expr::node_t e) { e.alpha *= s, e.beta *= s; return e; }
+expr::node_t operator*(expr::node_t e, float s) { e.alpha *= s, e.beta *= s; return e; }
+expr::node_t operator-(expr::node_t e)          { e.alpha = -e.alpha, e.beta = -e.beta; return e; }
+
+expr::node_t operator*(expr::term_t x, expr::term_t y) { return expr::node_t(std::move(x), std::move(y)); }
+
+// one addend per node: a second one evaluates what is there first
+expr::node_t operator+(expr::node_t e, expr::term_t y)
+{
+    if (e.c)
+        return expr::node_t(expr::term_t(std::move(e))) + std::move(y);
+    e.beta = y.scale;
+    e.c.emplace(std::move(y));
+    e.c->scale = 1.f;
+    return e;
+}
+expr::node_t operator+(expr::term_t x, expr::node_t e) { return std::move(e) + std::move(x); }
+expr::node_t operator+(expr::term_t x, expr::term_t y) { return expr::node_t(std::move(x)) + std::move(y); }
+expr::node_t operator+(expr::node_t e, expr::node_t f) { return std::move(e) + expr::term_t(std::move(f)); }
+
+expr::node_t operator-(expr::node_t e, expr::term_t y) { return std::move(e) + -std::move(y); }
+expr::node_t operator-(expr::term_t x, expr::node_t e) { return -std::move(e) + std::move(x); }
+expr::node_t operator-(expr::term_t x, expr::term_t y) { return std::move(x) + -std::move(y); }
+expr::node_t operator-(expr::node_t e, expr::node_t f) { return std::move(e) + -expr::term_t(std::move(f)); }
+
+Matrix<float> & operator+=(Matrix<float> & D, expr::node_t e) { std::move(e).add_to(D,  1.f); return D; }
+Matrix<float> & operator-=(Matrix<float> & D, expr::node_t e) { std::move(e).add_to(D, -1.f); return D; }
+Matrix<float> & operator+=(Matrix<float> & D, expr::term_t x) { std::move(x).add_to(D,  1.f); return D; }
+Matrix<float> & operator-=(Matrix<float> & D, expr::term_t x) { std::move(x).add_to(D, -1.f); return D; }
+
+// the same with the sgemm on a pool
+Matrix<float> evaluate(expr::node_t e, ThreadPool * pool = nullptr)
+{
+    return std::move(e).eval(pool);
+}
+
+void assign(Matrix<float> & D, expr::node_t e, ThreadPool * pool = nullptr)
+{
+    std::move(e).assign_to(D, pool);
+}
@@ -0,0 +1,319 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <cmath>
+#include <vector>
+
+// Blocked TRSM, LU with partial pivoting and Cholesky, row-major. The diagonal blocks and
+// panels are solved by plain loops split over the ThreadPool, everything off the diagonal
+// blocks is a C -= A * B update (alpha = -1, beta = 1) on the blocked sgemm, or on ssyrk
+// for the symmetric trailing matrix of Cholesky
+
+namespace detail
+{
+
+// sgemm on a workspace made once for the largest update of a factorization
+struct update_t
+{
+    ThreadPool * pool;
+    blocking_t blocking;
+    buf_t bufB;
+    std::vector<buf_t> bufA;
+
+    update_t(int M, int N, int K, ThreadPool * pool)
+    : pool(pool)
+    , blocking(make_blocking(std::max(1, M), std::max(1, N), std::max(1, K), pool ? pool->size() : 1))
+    , bufB((pool ? 2 : 1) * bufB_size(blocking))
+    {
+        for (int t = 0; t < (pool ? blocking.tM * blocking.tN : 1); ++t)
+            bufA.emplace_back(bufA_size(blocking));
+    }
+
+    void operator()( char transA, char transB, int M, int N, int K
+                   , float alpha, const float * A, int lda
+                   ,              const float * B, int ldb
+                   , float beta ,       float * C, int ldc
+                   )
+    {
+        if (pool)
+            sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA, *pool);
+        else
+            sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA[0]);
+    }
+};
+
+// op(A) X = B for columns [c0, c1) of B, the rows are solved in order and each one is an axpy
+void trsm_left( bool lower, char transA, bool unit, int M, int c0, int c1
+              , const float * A, int lda
+              ,       float * B, int ldb
+              )
+{
+    for (int q = 0; q < M; ++q)
+    {
+        const int i = lower ? q : M - 1 - q; // forward for lower, backward for upper
+        float * bi = B + i * ldb;
+
+        for (int p = lower ? 0 : i + 1; p < (lower ? i : M); ++p)
+        {
+            const float aip = *at(transA, A, lda, i, p);
+            const float * bp = B + p * ldb;
+            for (int c = c0; c < c1; ++c)
+                bi[c] -= aip * bp[c];
+        }
+        if (!unit)
+        {
+            const float d = 1.f / *at(transA, A, lda, i, i);
+            for (int c = c0; c < c1; ++c)
+                bi[c] *= d;
+        }
+    }
+}
+
+// op(A) X = B or X op(A) = B for one diagonal block, unit: the diagonal is taken as 1;
+// left: the columns of B are split over the pool, right: the rows, each chunk solved
+// transposed, op(A)^T X^T = B^T, so that it runs on contiguous axpys as well
+void trsm_block( bool left, bool lower, char transA, bool unit, int M, int N
+               , const float * A, int lda
+               ,       float * B, int ldb
+               , ThreadPool * pool
+               )
+{
+    if (left)
+    {
+        const int T = tasks(pool, N, 64);
+        return parallel_for(pool, T, [&](int t)
+        {
+            trsm_left(lower, transA, unit, M, N * t / T, N * (t + 1) / T, A, lda, B, ldb);
+        });
+    }
+
+    const int T = tasks(pool, M, 64);
+    parallel_for(pool, T, [&](int t)
+    {
+        const int r0 = M * t / T, dR = M * (t + 1) / T - r0;
+        std::vector<float> Xt(std::size_t(N) * dR); // N x dR
+
+        for (int r = 0; r < dR; ++r)
+            for (int c = 0; c < N; ++c)
+                Xt[c * dR + r] = B[(r0 + r) * ldb + c];
+
+        trsm_left(!lower, is_trans(transA) ? 'N' : 'T', unit, N, 0, dR, A, lda, Xt.data(), dR);
+
+        for (int r = 0; r < dR; ++r)
+            for (int c = 0; c < N; ++c)
+                B[(r0 + r) * ldb + c] = Xt[c * dR + r];
+    });
+}
+
+// blocked TRSM on a caller's update workspace, alpha is already applied to B
+void trsm( bool left, bool lower, char transA, bool unit, int M, int N
+         , const float * A, int lda
+         ,       float * B, int ldb
+         , int nb, update_t & update
+         )
+{
+    const int n = left ? M : N; // order of op(A)
+
+    for (int q = 0; q < n; q += nb)
+    {
+        const int kb = std::min(nb, n - q);
+        const int k  = lower == left ? q : n - q - kb; // left lower and right upper go forward
+
+        const float * Akk = at(transA, A, lda, k, k);
+
+        if (left)
+        {
+            trsm_block(true, lower, transA, unit, kb, N, Akk, lda, B + k * ldb, ldb, update.pool);
+
+            if (lower) // B[k+kb:, :] -= op(A)[k+kb:, k:k+kb] * X[k:k+kb, :]
+                update(transA, 'N', M - k - kb, N, kb, -1.f, at(transA, A, lda, k + kb, k), lda, B + k * ldb, ldb, 1.f, B + (k + kb) * ldb, ldb);
+            else       // B[:k, :]    -= op(A)[:k, k:k+kb]    * X[k:k+kb, :]
+                update(transA, 'N', k, N, kb, -1.f, at(transA, A, lda, 0, k), lda, B + k * ldb, ldb, 1.f, B, ldb);
+        }
+        else
+        {
+            trsm_block(false, lower, transA, unit, M, kb, Akk, lda, B + k, ldb, update.pool);
+
+            if (!lower) // B[:, k+kb:] -= X[:, k:k+kb] * op(A)[k:k+kb, k+kb:]
+                update('N', transA, M, N - k - kb, kb, -1.f, B + k, ldb, at(transA, A, lda, k, k + kb), lda, 1.f, B + k + kb, ldb);
+            else        // B[:, :k]    -= X[:, k:k+kb] * op(A)[k:k+kb, :k]
+                update('N', transA, M, k, kb, -1.f, B + k, ldb, at(transA, A, lda, k, 0), lda, 1.f, B, ldb);
+        }
+    }
+}
+
+} // namespace detail
+
+// Row-major BLAS strsm: op(A) X = alpha B (side 'L') or X op(A) = alpha B (side 'R'), X overwrites B;
+// A is triangular ('L'ower or 'U'pper as stored), diag 'U' takes its diagonal as 1
+void strsm( char side, char uplo, char transA, char diag, int M, int N
+          , float alpha, const float * A, int lda
+          ,                    float * B, int ldb
+          , ThreadPool * pool = nullptr
+          , int nb = 64
+          )
+{
+    if (M <= 0 || N <= 0)
+        return;
+
+    kernel().init_c(M, N, B, ldb, alpha);
+    if (alpha == 0.f)
+        return;
+
+    const bool left  = side == 'L' || side == 'l';
+    const bool lower = (uplo == 'L' || uplo == 'l') != is_trans(transA); // of op(A)
+    const bool unit  = diag == 'U' || diag == 'u';
+
+    detail::update_t update(M, N, std::min(nb, left ? M : N), pool);
+    detail::trsm(left, lower, transA, unit, M, N, A, lda, B, ldb, std::max(1, nb), update);
+}
+
+// LU with partial pivoting of the M x N A: P A = L U, L unit lower (below the diagonal of A),
+// U upper; row i was swapped with row ipiv[i] >= i (0-based), ipiv has min(M, N) entries.
+// Returns 0, or i + 1 for the first exactly zero pivot U(i, i) (the factorization is still completed)
+int sgetrf( int M, int N, float * A, int lda, int * ipiv
+          , ThreadPool * pool = nullptr
+          , int nb = 64
+          )
+{
+    const int MN = std::min(M, N);
+    if (MN <= 0)
+        return 0;
+    nb = std::max(1, nb);
+
+    detail::update_t update(M, N, std::min(nb, MN), pool);
+    int info = 0;
+
+    for (int k = 0; k < MN; k += nb)
+    {
+        const int kb = std::min(nb, MN - k);
+
+
+        // panel A[k:, k:k+kb], column by column; its rows are split over the pool
+        const int T = detail::tasks(pool, M - k, 256);
+        std::vector<int> rowmax(T);
+
+        for (int j = k; j < k + kb; ++j)
+        {
+            detail::parallel_for(pool, T, [&](int t) // pivot: largest |A(i, j)|, i >= j
+            {
+                int r0 = j + (M - j) * t / T, r1 = j + (M - j) * (t + 1) / T;
+                int p  = r0;
+                for (int i = r0 + 1; i < r1; ++i)
+                    if (std::abs(A[i * lda + j]) > std::abs(A[p * lda + j]))
+                        p = i;
+                rowmax[t] = p;
+            });
+
+            int p = rowmax[0];
+            for (int t = 1; t < T; ++t)
+                if (std::abs(A[rowmax[t] * lda + j]) > std::abs(A[p * lda + j]))
+                    p = rowmax[t];
+
+            ipiv[j] = p;
+            if (p != j)
+                std::swap_ranges(A + j * lda + k, A + j * lda + k + kb, A + p * lda + k);
+
+            const float d = A[j * lda + j];
+            if (d == 0.f)
+            {
+                if (info == 0)
+                    info = j + 1;
+                continue;
+            }
+
+            detail::parallel_for(pool, T, [&](int t) // scale the column, rank-1 update of the rest of the panel
+            {
+                const float * uj = A + j * lda;
+                for (int i = j + 1 + (M - j - 1) * t / T; i < j + 1 + (M - j - 1) * (t + 1) / T; ++i)
+                {
+                    float * ai = A + i * lda;
+                    const float l = ai[j] /= d;
+                    for (int c = j + 1; c < k + kb; ++c)
+                        ai[c] -= l * uj[c];
+                }
+            });
+        }
+
+
+        // the panel's swaps on the columns left and right of it
+        for (int j = k; j < k + kb; ++j)
+            if (ipiv[j] != j)
+            {
+                float * a = A + j * lda, * b = A + ipiv[j] * lda;
+                std::swap_ranges(a, a + k, b);
+                std::swap_ranges(a + k + kb, a + N, b + k + kb);
+            }
+
+        if (k + kb >= N)
+            continue;
+
+        // U12 = L11^-1 A12, then the trailing update A22 -= L21 U12
+        detail::trsm(true, true, 'N', true, kb, N - k - kb, A + k * lda + k, lda, A + k * lda + k + kb, lda, nb, update);
+
+        if (k + kb < M)
+            update
+            (
+                'N', 'N', M - k - kb, N - k - kb, kb,
+                -1.f, A + (k + kb) * lda + k, lda,
+                      A +  k       * lda + k + kb, lda,
+                 1.f, A + (k + kb) * lda + k + kb, lda
+            );
+    }
+    return info;
+}
+
+// Cholesky of the symmetric positive definite N x N A: A = L L^T, L overwrites the lower triangle,
+// the strict upper triangle is neither read nor written. Returns 0, or j + 1 if the leading
+// minor of order j + 1 is not positive definite (the factorization stops there)
+int spotrf( int N, float * A, int lda
+          , ThreadPool * pool = nullptr
+          , int nb = 64
+          )
+{
+    if (N <= 0)
+        return 0;
+    nb = std::max(1, nb);
+
+    detail::update_t update(N, N, std::min(nb, N), pool);
+
+    for (int k = 0; k < N; k += nb)
+    {
+        const int kb = std::min(nb, N - k);
+        float * Akk = A + k * lda + k;
+
+
+        for (int j = 0; j < kb; ++j) // L11, unblocked: the block is small and its rows depend on each other
+        {
+            float * lj = Akk + j * lda;
+
+            float d = lj[j];
+            for (int p = 0; p < j; ++p)
+                d -= lj[p] * lj[p];
+            if (!(d > 0.f))
+                return k + j + 1;
+            lj[j] = std::sqrt(d);
+
+            for (int i = j + 1; i < kb; ++i)
+            {
+                float * li = Akk + i * lda;
+
+                float s = li[j];
+                for (int p = 0; p < j; ++p)
+                    s -= li[p] * lj[p];
+                li[j] = s / lj[j];
+            }
+        }
+
+        if (k + kb >= N)
+            break;
+
+        // panel L21 = A21 L11^-T, its rows split over the pool
+        float * A21 = A + (k + kb) * lda + k;
+        detail::trsm(false, false, 'T', false, N - k - kb, kb, Akk, lda, A21, lda, nb, update);
+
+
+        // trailing A22 -= L21 L21^T, lower triangle only
+        ssyrk('L', 'N', N - k - kb, kb, -1.f, A21, lda, 1.f, A + (k + kb) * lda + k + kb, lda, pool);
+    }
+    return 0;
+}
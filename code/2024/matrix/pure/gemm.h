@@ -1,25 +1,59 @@
+#pragma once
 #include "defs.h"
+#include "epilogue.h"
+#include "profile.h"
+#include "blocking.h"
 #include "micro.h"
 #include "reorder.h"
-#include "macro.h"
 #include "init.h"
+#include "scalar.h"
+#include "avx512.h"
+#include "dispatch.h"
+#include "macro.h"
+#include "ksplit.h"
+#include "parallel.h"
+#include "plan.h"
+#include "packed.h"
+#include "autotune.h"
+#include "batched.h"
+#include "int8.h"
+#include "../tools/matrix.h"
+#include "strassen.h"
+#include "gemv.h"
+#include "symm.h"
+#include "half.h"
+#include "sparse.h"
+#include "conv.h"
+#include "cgemm.h"
+#include "transpose.h"
+#include "expr.h"
+#include "einsum.h"
+#include "factor.h"
 
-void gemm( int M, int N, int K
-         , const float * A
-         , const float * B
-         ,       float * C
-         )
+// Single-threaded, on a caller-provided workspace sized by bufB_size / bufA_size;
+// C = epi(alpha * op(A) * op(B) + beta * C), epi is fused into the last K block, see epilogue.h
+template<typename Epi>
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , const blocking_t & blocking
+          , buf_t & bufB
+          , buf_t & bufA
+          , const Epi & epi
+          )
 {
-    const int L1 =       32 * 1024
-            , L2 =      256 * 1024
-            , L3 = 2 * 1024 * 1024;
+    if (M <= 0 || N <= 0)
+        return;
+    const kernel_t & ker = *blocking.ker;
 
-    int mK = std::min(L1 / 4 / 16, K) /  4 *  4;
-    int mM = std::min(L2 / 4 / mK, M) /  6 *  6;
-    int mN = std::min(L3 / 4 / mK, N) / 16 * 16;
+    if (K <= 0 || alpha == 0.f)
+    {
+        ker.init_c(M, N, C, ldc, beta);
+        return apply_epilogue(M, N, C, ldc, epi);
+    }
 
-    buf_t bufB(mN * mK);
-    buf_t bufA(mK * mM);
+    const auto [mK, mM, mN, tM, tN, _] = blocking;
 
     for (int j = 0; j < N; j += mN) // cycle 6: macro for B
     {
@@ -32,24 +66,120 @@ void gemm( int M, int N, int K
 
 
             for (int i = 0; i < M; i += mM) // cycle 4: macro for A and reorder A,
-                                            //          optionally init C 
+                                            //          optionally scale C by beta
             {
                 int dM = std::min(M, i + mM) - i;
 
 
                 if (k == 0)
-                    init_c(dM, dN, C + i * N + j, N);
+                    ker.init_c(dM, dN, C + i * ldc + j, ldc, beta);
 
 
-                reorder_a_6(A + i * K + k, K, dM, dK, bufA.p);
-                macro
-                ( 
-                    dM, dN, dK, 
-                    bufA.p, 
-                    B + k * N + j, N, bufB.p, i == 0, 
-                    C + i * N + j, N
-                );
+                ker.pack_a(transA, at(transA, A, lda, i, k), lda, dM, dK, alpha, bufA.p);
+                if (k + dK < K)
+                    macro
+                    ( 
+                        ker,
+                        dM, dN, dK, 
+                        bufA.p, 
+                        transB, at(transB, B, ldb, k, j), ldb, bufB.p, i == 0, 
+                        C + i * ldc + j, ldc
+                    );
+                else
+                    macro
+                    (
+                        ker,
+                        dM, dN, dK,
+                        bufA.p,
+                        transB, at(transB, B, ldb, k, j), ldb, bufB.p, i == 0,
+                        C + i * ldc + j, ldc,
+                        epi, i, j
+                    );
             }
         }
     }
 }
+
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , const blocking_t & blocking
+          , buf_t & bufB
+          , buf_t & bufA
+          )
+{
+    sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA, epi_none());
+}
+
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          )
+{
+    if (M <= 0 || N <= 0 || K <= 0 || alpha == 0.f)
+        return kernel().init_c(M, N, C, ldc, beta);
+
+    const blocking_t blocking = make_blocking(M, N, K, 1);
+
+    buf_t bufB(bufB_size(blocking));
+    buf_t bufA(bufA_size(blocking));
+
+    sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA);
+}
+
+template<typename Epi>
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , const Epi & epi
+          )
+{
+    if (M <= 0 || N <= 0 || K <= 0 || alpha == 0.f)
+    {
+        kernel().init_c(M, N, C, ldc, beta);
+        return apply_epilogue(M, N, C, ldc, epi);
+    }
+
+    const blocking_t blocking = make_blocking(M, N, K, 1);
+
+    buf_t bufB(bufB_size(blocking));
+    buf_t bufA(bufA_size(blocking));
+
+    sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA, epi);
+}
+
+void gemm( int M, int N, int K
+         , const float * A
+         , const float * B
+         ,       float * C
+         )
+{
+    sgemm('N', 'N', M, N, K, 1.f, A, K, B, N, 0.f, C, N);
+}
+
+// Matrix<float> operands: shapes are taken from op(A), op(B) and C, strides from memoryWidth
+void sgemm( char transA, char transB
+          , float alpha, const Matrix<float> & A
+          ,              const Matrix<float> & B
+          , float beta ,       Matrix<float> & C
+          )
+{
+    const int M = C.height
+            , N = C.width
+            , K = is_trans(transA) ? A.height : A.width;
+
+    assert((is_trans(transA) ? A.width  : A.height) == std::size_t(M));
+    assert((is_trans(transB) ? B.height : B.width ) == std::size_t(N));
+    assert((is_trans(transB) ? B.width  : B.height) == std::size_t(K));
+
+    sgemm
+    (
+        transA, transB, M, N, K,
+        alpha, A.memory.get(), A.memoryWidth,
+               B.memory.get(), B.memoryWidth,
+        beta , C.memory.get(), C.memoryWidth
+    );
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include "../tools/threadpool.h"
+
+// SGEMV: y = alpha * op(A) * x + beta * y, each element of A read once.
+// 'N': rows of A are independent dot products, split over the pool;
+// 'T': every row of A is an axpy into y, the columns (and y) are split over the pool.
+// A column-major A is the row-major A^T: pass it with the other trans
+
+AVX2 void gemv_n(int M, int N, float alpha, const float * A, int lda, const float * x, float beta, float * y) // M rows of y
+{
+    const __m256i m = mask_8(N % 8);
+    const int     n = N - N % 8;
+
+    auto hsum = [](__m256 v) AVX2
+    {
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        return _mm_cvtss_f32(_mm_add_ss(s, _mm_movehdup_ps(s)));
+    };
+
+    int i = 0;
+    for (; i + 4 <= M; i += 4, A += 4 * lda) // four rows share each load of x
+    {
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+
+        int j = 0;
+        for (; j < n; j += 8)
+        {
+            const __m256 xj = _mm256_loadu_ps(x + j);
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(A + 0 * lda + j), xj, s0);
+            s1 = _mm256_fmadd_ps(_mm256_loadu_ps(A + 1 * lda + j), xj, s1);
+            s2 = _mm256_fmadd_ps(_mm256_loadu_ps(A + 2 * lda + j), xj, s2);
+            s3 = _mm256_fmadd_ps(_mm256_loadu_ps(A + 3 * lda + j), xj, s3);
+        }
+        if (j < N)
+        {
+            const __m256 xj = _mm256_maskload_ps(x + j, m);
+            s0 = _mm256_fmadd_ps(_mm256_maskload_ps(A + 0 * lda + j, m), xj, s0);
+            s1 = _mm256_fmadd_ps(_mm256_maskload_ps(A + 1 * lda + j, m), xj, s1);
+            s2 = _mm256_fmadd_ps(_mm256_maskload_ps(A + 2 * lda + j, m), xj, s2);
+            s3 = _mm256_fmadd_ps(_mm256_maskload_ps(A + 3 * lda + j, m), xj, s3);
+        }
+
+        const float r[4] = { hsum(s0), hsum(s1), hsum(s2), hsum(s3) };
+        for (int q = 0; q < 4; ++q)
+            y[i + q] = alpha * r[q] + (beta == 0.f ? 0.f : beta * y[i + q]);
+    }
+    for (; i < M; ++i, A += lda)
+    {
+        __m256 s = _mm256_setzero_ps();
+        int j = 0;
+        for (; j < n; j += 8)
+            s = _mm256_fmadd_ps(_mm256_loadu_ps(A + j), _mm256_loadu_ps(x + j), s);
+        if (j < N)
+            s = _mm256_fmadd_ps(_mm256_maskload_ps(A + j, m), _mm256_maskload_ps(x + j, m), s);
+
+        y[i] = alpha * hsum(s) + (beta == 0.f ? 0.f : beta * y[i]);
+    }
+}
+
+AVX2 void gemv_t(int M, int N, float alpha, const float * A, int lda, const float * x, float beta, float * y) // N columns of y
+{
+    const __m256i m = mask_8(N % 8);
+    const int     n = N - N % 8;
+
+    kernel().init_c(1, N, y, N, beta);
+
+    int i = 0;
+    for (; i + 4 <= M; i += 4, A += 4 * lda) // four rows per pass over y
+    {
+        const __m256 x0 = _mm256_set1_ps(alpha * x[i + 0]), x1 = _mm256_set1_ps(alpha * x[i + 1]);
+        const __m256 x2 = _mm256_set1_ps(alpha * x[i + 2]), x3 = _mm256_set1_ps(alpha * x[i + 3]);
+
+        int j = 0;
+        for (; j < n; j += 8)
+        {
+            __m256 s = _mm256_loadu_ps(y + j);
+            s = _mm256_fmadd_ps(_mm256_loadu_ps(A + 0 * lda + j), x0, s);
+            s = _mm256_fmadd_ps(_mm256_loadu_ps(A + 1 * lda + j), x1, s);
+            s = _mm256_fmadd_ps(_mm256_loadu_ps(A + 2 * lda + j), x2, s);
+            s = _mm256_fmadd_ps(_mm256_loadu_ps(A + 3 * lda + j), x3, s);
+            _mm256_storeu_ps(y + j, s);
+        }
+        if (j < N)
+        {
+            __m256 s = _mm256_maskload_ps(y + j, m);
+            s = _mm256_fmadd_ps(_mm256_maskload_ps(A + 0 * lda + j, m), x0, s);
+            s = _mm256_fmadd_ps(_mm256_maskload_ps(A + 1 * lda + j, m), x1, s);
+            s = _mm256_fmadd_ps(_mm256_maskload_ps(A + 2 * lda + j, m), x2, s);
+            s = _mm256_fmadd_ps(_mm256_maskload_ps(A + 3 * lda + j, m), x3, s);
+            _mm256_maskstore_ps(y + j, m, s);
+        }
+    }
+    for (; i < M; ++i, A += lda)
+    {
+        const __m256 xi = _mm256_set1_ps(alpha * x[i]);
+
+        int j = 0;
+        for (; j < n; j += 8)
+            _mm256_storeu_ps(y + j, _mm256_fmadd_ps(_mm256_loadu_ps(A + j), xi, _mm256_loadu_ps(y + j)));
+        if (j < N)
+            _mm256_maskstore_ps(y + j, m, _mm256_fmadd_ps(_mm256_maskload_ps(A + j, m), xi, _mm256_maskload_ps(y + j, m)));
+    }
+}
+
+void gemv_n_generic(int M, int N, float alpha, const float * A, int lda, const float * x, float beta, float * y)
+{
+    for (int i = 0; i < M; ++i, A += lda)
+    {
+        float s = 0.f;
+        for (int j = 0; j < N; ++j)
+            s += A[j] * x[j];
+        y[i] = alpha * s + (beta == 0.f ? 0.f : beta * y[i]);
+    }
+}
+
+void gemv_t_generic(int M, int N, float alpha, const float * A, int lda, const float * x, float beta, float * y)
+{
+    init_c_generic(1, N, y, N, beta);
+
+    for (int i = 0; i < M; ++i, A += lda)
+        for (int j = 0; j < N; ++j)
+            y[j] += alpha * x[i] * A[j];
+}
+
+void sgemv( char trans, int M, int N // A is M x N
+          , float alpha, const float * A, int lda
+          ,              const float * x
+          , float beta ,       float * y
+          , ThreadPool * pool = nullptr
+          )
+{
+    if (M <= 0 || N <= 0)
+        return;
+
+    static const bool avx2 = find_kernel("avx2") != nullptr;
+    const bool t = is_trans(trans);
+
+    // the split dimension: rows of A for 'N', columns for 'T', at least 8K elements of A per task
+    const int n = t ? N : M;
+    const int T = detail::tasks(pool, n, std::max(1, 8192 / (t ? M : N)));
+
+    detail::parallel_for(pool, T, [&](int q)
+    {
+        const int r0 = n * q / T, dR = n * (q + 1) / T - r0;
+        if (dR <= 0)
+            return;
+
+        if (t)
+            (avx2 ? gemv_t : gemv_t_generic)(M, dR, alpha, A + r0, lda, x, beta, y + r0);
+        else
+            (avx2 ? gemv_n : gemv_n_generic)(dR, N, alpha, A + r0 * lda, lda, x, beta, y + r0);
+    });
+}
@@ -0,0 +1,248 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <cstdint>
+#include <cstring>
+
+// 16-bit storage for A and B: the packers widen to fp32, so the fp32 kernels,
+// the blocking and the accumulation are the same as in sgemm; only the memory traffic halves
+
+struct bf16_t { uint16_t bits; }; // upper half of an fp32
+struct fp16_t { uint16_t bits; }; // IEEE binary16
+
+inline float to_float(bf16_t x)
+{
+    uint32_t u = uint32_t(x.bits) << 16;
+    float f;
+    std::memcpy(&f, &u, 4);
+    return f;
+}
+
+inline float to_float(fp16_t x) // portable path, F16C does the same in hardware
+{
+    uint32_t sign = uint32_t(x.bits & 0x8000) << 16;
+    uint32_t exp  = (x.bits >> 10) & 0x1f;
+    uint32_t man  =  x.bits        & 0x3ff;
+
+    uint32_t u;
+    if (exp == 0x1f)     // inf, nan
+        u = sign | 0x7f800000 | man << 13;
+    else if (exp != 0)   // normal
+        u = sign | (exp + 112) << 23 | man << 13;
+    else if (man == 0)   // zero
+        u = sign;
+    else                 // subnormal: renormalize
+    {
+        exp = 113;
+        while (!(man & 0x400))
+            man <<= 1, --exp;
+        u = sign | exp << 23 | (man & 0x3ff) << 13;
+    }
+
+    float f;
+    std::memcpy(&f, &u, 4);
+    return f;
+}
+
+inline bf16_t to_bf16(float f) // round to nearest even
+{
+    uint32_t u;
+    std::memcpy(&u, &f, 4);
+    if ((u & 0x7fffffff) > 0x7f800000) // keep nan a nan
+        return { uint16_t(u >> 16 | 0x40) };
+    return { uint16_t((u + 0x7fff + (u >> 16 & 1)) >> 16) };
+}
+
+inline fp16_t to_fp16(float f) // round to nearest even, overflow to inf
+{
+    uint32_t u;
+    std::memcpy(&u, &f, 4);
+
+    uint16_t sign = (u >> 16) & 0x8000;
+    uint32_t a    =  u & 0x7fffffff;
+
+    if (a > 0x7f800000) return { uint16_t(sign | 0x7e00) };              // nan
+    if (a >= 0x477ff000) return { uint16_t(sign | 0x7c00) };             // rounds to inf
+    if (a >= 0x38800000)                                                 // normal
+    {
+        uint32_t r = a - (112u << 23);
+        return { uint16_t(sign | (r + 0xfff + (r >> 13 & 1)) >> 13) };
+    }
+    if (a < 0x33000000) return { sign };                                 // below half of the smallest subnormal
+
+    uint32_t man   = (a & 0x7fffff) | 0x800000;                          // subnormal
+    int      shift = 126 - int(a >> 23);
+    uint32_t half  = 1u << (shift - 1);
+    uint32_t r     = man >> shift;
+    uint32_t rest  = man & ((1u << shift) - 1);
+    if (rest > half || (rest == half && (r & 1)))
+        ++r;
+    return { uint16_t(sign | r) };
+}
+
+F16C inline __m256 widen_8(const bf16_t * p)
+{
+    __m128i h = _mm_loadu_si128((const __m128i *)p);
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+F16C inline __m256 widen_8(const fp16_t * p)
+{
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)p));
+}
+
+// one micro-panel of B: K x N into K x NR, zero-padded, NR a multiple of 8
+template<typename H>
+F16C void pack_b_half(int K, int N, int NR, const H * B, int ldb, float * bufB)
+{
+    for (int k = 0; k < K; ++k, B += ldb, bufB += NR)
+    {
+        int c = 0;
+        for (; c + 8 <= N; c += 8)
+            _mm256_storeu_ps(bufB + c, widen_8(B + c));
+        for (; c < NR; ++c)
+            bufB[c] = c < N ? to_float(B[c]) : 0.f;
+    }
+}
+
+// M x K block of A into MR-row panels scaled by alpha, zero-padded;
+// rows are widened 8 k at a time and scattered into the panel
+template<typename H>
+F16C void pack_a_half(int M, int K, int MR, const H * A, int lda, float alpha, float * bufA)
+{
+    const __m256 a = _mm256_set1_ps(alpha);
+
+    for (int i = 0; i < M; i += MR, A += MR * lda, bufA += MR * K)
+    {
+        int dM = std::min(M - i, MR);
+
+        for (int r = 0; r < MR; ++r)
+        {
+            float * p = bufA + r;
+            if (r >= dM)
+            {
+                for (int k = 0; k < K; ++k)
+                    p[k * MR] = 0.f;
+                continue;
+            }
+
+            int k = 0;
+            for (; k + 8 <= K; k += 8)
+            {
+                alignas(32) float w[8];
+                _mm256_store_ps(w, _mm256_mul_ps(a, widen_8(A + r * lda + k)));
+                for (int t = 0; t < 8; ++t)
+                    p[(k + t) * MR] = w[t];
+            }
+            for (; k < K; ++k)
+                p[k * MR] = alpha * to_float(A[r * lda + k]);
+        }
+    }
+}
+
+// portable packers for CPUs without F16C
+template<typename H>
+void pack_b_half_generic(int K, int N, int NR, const H * B, int ldb, float * bufB)
+{
+    for (int k = 0; k < K; ++k, B += ldb, bufB += NR)
+        for (int c = 0; c < NR; ++c)
+            bufB[c] = c < N ? to_float(B[c]) : 0.f;
+}
+
+template<typename H>
+void pack_a_half_generic(int M, int K, int MR, const H * A, int lda, float alpha, float * bufA)
+{
+    for (int i = 0; i < M; i += MR, A += MR * lda)
+    {
+        int dM = std::min(M - i, MR);
+
+        for (int k = 0; k < K; ++k, bufA += MR)
+            for (int r = 0; r < MR; ++r)
+                bufA[r] = r < dM ? alpha * to_float(A[r * lda + k]) : 0.f;
+    }
+}
+
+// Row-major C = alpha * A * B + beta * C with A and B in H, C in fp32;
+// the loop nest of the blocked sgemm (symm.h) with the half packers in place of the kernel's own;
+// pool == nullptr runs inline
+template<typename H>
+void gemm_half( int M, int N, int K
+              , float alpha, const H * A, int lda
+              ,              const H * B, int ldb
+              , float beta ,   float * C, int ldc
+              , const kernel_t & ker = kernel()
+              , ThreadPool * pool = nullptr
+              )
+{
+    if (M <= 0 || N <= 0)
+        return;
+
+    ker.init_c(M, N, C, ldc, beta);
+    if (K <= 0 || alpha == 0.f)
+        return;
+
+    static const bool f16c = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+    const bool wide = f16c && ker.NR % 8 == 0;
+
+    detail::blocked
+    (
+        make_blocking(M, N, K, pool ? pool->size() : 1, ker), M, N, K,
+        [&](int i, int k, int dM, int dK, float * buf) // widening
+        {
+            if (wide)
+                pack_a_half        (dM, dK, ker.MR, A + i * lda + k, lda, alpha, buf);
+            else
+                pack_a_half_generic(dM, dK, ker.MR, A + i * lda + k, lda, alpha, buf);
+        },
+        [&](int k, int j, int dK, int dN, float * buf) // per micro-panel, widening
+        {
+            if (wide)
+                pack_b_half        (dK, dN, ker.NR, B + k * ldb + j, ldb, buf);
+            else
+                pack_b_half_generic(dK, dN, ker.NR, B + k * ldb + j, ldb, buf);
+        },
+        [](int, int, int, int) { return false; },
+        [&](int i, int dM, int j, int dN, int dK, const float * bufA, float * bufB)
+        {
+            macro(ker, dM, dN, dK, bufA, 'N', nullptr, 0, bufB, false, C + i * ldc + j, ldc);
+        },
+        pool
+    );
+}
+
+void gemm( int M, int N, int K
+         , const bf16_t * A
+         , const bf16_t * B
+         ,        float * C
+         )
+{
+    gemm_half(M, N, K, 1.f, A, K, B, N, 0.f, C, N);
+}
+
+void gemm( int M, int N, int K
+         , const fp16_t * A
+         , const fp16_t * B
+         ,        float * C
+         )
+{
+    gemm_half(M, N, K, 1.f, A, K, B, N, 0.f, C, N);
+}
+
+void gemm( int M, int N, int K
+         , const bf16_t * A
+         , const bf16_t * B
+         ,        float * C
+         , ThreadPool & pool
+         )
+{
+    gemm_half(M, N, K, 1.f, A, K, B, N, 0.f, C, N, kernel(), &pool);
+}
+
+void gemm( int M, int N, int K
+         , const fp16_t * A
+         , const fp16_t * B
+         ,        float * C
+         , ThreadPool & pool
+         )
+{
+    gemm_half(M, N, K, 1.f, A, K, B, N, 0.f, C, N, kernel(), &pool);
+}
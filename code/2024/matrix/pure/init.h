@@ -1,6 +1,34 @@
-void init_c(int M, int N, float * C, int ldc)
+AVX2 void init_c(int M, int N, float * C, int ldc, float beta) // C = beta * C, C is not read for beta == 0
 {
+    if (beta == 1.f)
+        return;
+
+    const __m256 b = _mm256_set1_ps(beta);
+
     for (int i = 0; i < M; ++i, C += ldc)
-        for (int j = 0; j < N; j += 8)
-            _mm256_storeu_ps(C + j, _mm256_setzero_ps());
+    {
+        int j = 0;
+        for (; j + 8 <= N; j += 8)
+            _mm256_storeu_ps(C + j, beta == 0.f ? _mm256_setzero_ps() : _mm256_mul_ps(b, _mm256_loadu_ps(C + j)));
+        if (j < N)
+        {
+            const __m256i m = mask_8(N - j);
+            _mm256_maskstore_ps(C + j, m, beta == 0.f ? _mm256_setzero_ps() : _mm256_mul_ps(b, _mm256_maskload_ps(C + j, m)));
+        }
+    }
+}
+
+AVX2 void add_c(int M, int N, const float * P, int ldp, float * C, int ldc) // C += P
+{
+    for (int i = 0; i < M; ++i, P += ldp, C += ldc)
+    {
+        int j = 0;
+        for (; j + 8 <= N; j += 8)
+            _mm256_storeu_ps(C + j, _mm256_add_ps(_mm256_loadu_ps(C + j), _mm256_loadu_ps(P + j)));
+        if (j < N)
+        {
+            const __m256i m = mask_8(N - j);
+            _mm256_maskstore_ps(C + j, m, _mm256_add_ps(_mm256_maskload_ps(C + j, m), _mm256_maskload_ps(P + j, m)));
+        }
+    }
 }
@@ -0,0 +1,612 @@
+#pragma once
+#include "cache.h"
+#include "parallel.h"
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+// Quantized gemm: u8 x s8 -> s32. k is packed in groups of 4 bytes, the amount one
+// 32-bit lane of a single vpdpbusd (or two vpmaddwd) consumes:
+// packed A is MR x K4 panels (4 * MR bytes per group), packed B is K4 x NR panels (4 * NR bytes per group).
+// Signed A is flipped to u8 (a + 128) while packing and corrected with the column sums of B.
+//
+// Without VNNI the bytes are widened to s16 and multiplied in pairs by vpmaddwd. vpmaddubsw
+// would take the bytes as they are, at about twice the speed, but adds two u8 * s8 products
+// into a saturating s16: it is used only when every |b| <= 64 (7-bit weights), where it cannot saturate.
+
+struct ikernel_t
+{
+    const char * name;
+    int MR, NR;
+
+    void (*micro)(int K4, const uint8_t * A, const int8_t * B, int32_t * C, int ldc); // C += A * B, MR x NR
+    void (*micro_narrow)(int K4, const uint8_t * A, const int8_t * B, int32_t * C, int ldc); // the same for |b| <= 64,
+                                                                                           // nullptr if micro is as fast
+};
+
+// the bytes of a k group are split into even (k0, k2) and odd (k1, k3) s16 pairs: two vpmaddwd per group, exact
+AVX2 void micro_u8s8_6x16(int K4, const uint8_t * A, const int8_t * B, int32_t * C, int ldc)
+{
+    const __m256i lo = _mm256_set1_epi16(0x00FF);
+    __m256i c[6][2];
+
+    #pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i) // C is loaded up front, see micro_u8s8_14x32
+    {
+        c[i][0] = _mm256_loadu_si256((const __m256i *)(C + i * ldc + 0));
+        c[i][1] = _mm256_loadu_si256((const __m256i *)(C + i * ldc + 8));
+    }
+
+    for (int k = 0; k < K4; ++k, A += 6 * 4, B += 16 * 4) // cycle 1: 4 k at once
+    {
+        __m256i b0 = _mm256_loadu_si256((const __m256i *)(B +  0));
+        __m256i b1 = _mm256_loadu_si256((const __m256i *)(B + 32));
+        __m256i e0 = _mm256_srai_epi16(_mm256_slli_epi16(b0, 8), 8), o0 = _mm256_srai_epi16(b0, 8);
+        __m256i e1 = _mm256_srai_epi16(_mm256_slli_epi16(b1, 8), 8), o1 = _mm256_srai_epi16(b1, 8);
+
+        #pragma GCC unroll 6
+        for (int i = 0; i < 6; ++i)
+        {
+            int32_t a4;
+            std::memcpy(&a4, A + 4 * i, 4);
+
+            __m256i a  = _mm256_set1_epi32(a4);
+            __m256i ae = _mm256_and_si256(a, lo), ao = _mm256_srli_epi16(a, 8);
+            c[i][0] = _mm256_add_epi32(c[i][0], _mm256_add_epi32(_mm256_madd_epi16(ae, e0), _mm256_madd_epi16(ao, o0)));
+            c[i][1] = _mm256_add_epi32(c[i][1], _mm256_add_epi32(_mm256_madd_epi16(ae, e1), _mm256_madd_epi16(ao, o1)));
+        }
+    }
+
+    #pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i, C += ldc)
+    {
+        _mm256_storeu_si256((__m256i *)(C + 0), c[i][0]);
+        _mm256_storeu_si256((__m256i *)(C + 8), c[i][1]);
+    }
+}
+
+// vpmaddubsw + vpmaddwd: |a0 * b0 + a1 * b1| <= 255 * 128 never saturates the s16 for |b| <= 64
+AVX2 void micro_u8s8_6x16_narrow(int K4, const uint8_t * A, const int8_t * B, int32_t * C, int ldc)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i c[6][2];
+
+    #pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i)
+    {
+        c[i][0] = _mm256_loadu_si256((const __m256i *)(C + i * ldc + 0));
+        c[i][1] = _mm256_loadu_si256((const __m256i *)(C + i * ldc + 8));
+    }
+
+    for (int k = 0; k < K4; ++k, A += 6 * 4, B += 16 * 4)
+    {
+        __m256i b0 = _mm256_loadu_si256((const __m256i *)(B +  0));
+        __m256i b1 = _mm256_loadu_si256((const __m256i *)(B + 32));
+
+        #pragma GCC unroll 6
+        for (int i = 0; i < 6; ++i)
+        {
+            int32_t a4;
+            std::memcpy(&a4, A + 4 * i, 4);
+
+            __m256i a = _mm256_set1_epi32(a4);
+            c[i][0] = _mm256_add_epi32(c[i][0], _mm256_madd_epi16(_mm256_maddubs_epi16(a, b0), ones));
+            c[i][1] = _mm256_add_epi32(c[i][1], _mm256_madd_epi16(_mm256_maddubs_epi16(a, b1), ones));
+        }
+    }
+
+    #pragma GCC unroll 6
+    for (int i = 0; i < 6; ++i, C += ldc)
+    {
+        _mm256_storeu_si256((__m256i *)(C + 0), c[i][0]);
+        _mm256_storeu_si256((__m256i *)(C + 8), c[i][1]);
+    }
+}
+
+// same register blocking as micro_14x32, one vpdpbusd per 64 multiply-adds;
+// C is loaded up front: adding it after the loop makes GCC keep the accumulators on the stack
+AVX512VNNI void micro_u8s8_14x32(int K4, const uint8_t * A, const int8_t * B, int32_t * C, int ldc)
+{
+    __m512i c[14][2];
+
+    #pragma GCC unroll 14
+    for (int i = 0; i < 14; ++i)
+    {
+        c[i][0] = _mm512_loadu_si512(C + i * ldc +  0);
+        c[i][1] = _mm512_loadu_si512(C + i * ldc + 16);
+    }
+
+    for (int k = 0; k < K4; ++k, A += 14 * 4, B += 32 * 4)
+    {
+        __m512i b0 = _mm512_loadu_si512(B +  0);
+        __m512i b1 = _mm512_loadu_si512(B + 64);
+
+        #pragma GCC unroll 14
+        for (int i = 0; i < 14; ++i)
+        {
+            int32_t a4;
+            std::memcpy(&a4, A + 4 * i, 4);
+
+            __m512i a = _mm512_set1_epi32(a4);
+            c[i][0] = _mm512_dpbusd_epi32(c[i][0], a, b0);
+            c[i][1] = _mm512_dpbusd_epi32(c[i][1], a, b1);
+        }
+    }
+
+    #pragma GCC unroll 14
+    for (int i = 0; i < 14; ++i, C += ldc)
+    {
+        _mm512_storeu_si512(C +  0, c[i][0]);
+        _mm512_storeu_si512(C + 16, c[i][1]);
+    }
+}
+
+template<int MR, int NR>
+void micro_u8s8_generic(int K4, const uint8_t * A, const int8_t * B, int32_t * C, int ldc)
+{
+    int32_t c[MR][NR] = {};
+
+    for (int k = 0; k < K4; ++k, A += MR * 4, B += NR * 4)
+        for (int i = 0; i < MR; ++i)
+            for (int j = 0; j < NR; ++j)
+                for (int t = 0; t < 4; ++t)
+                    c[i][j] += int32_t(A[i * 4 + t]) * int32_t(B[j * 4 + t]);
+
+    for (int i = 0; i < MR; ++i, C += ldc)
+        for (int j = 0; j < NR; ++j)
+            C[j] += c[i][j];
+}
+
+const ikernel_t ikernels[] =
+{
+    { "avx512vnni", 14, 32, micro_u8s8_14x32         , nullptr                },
+    { "avx2"      ,  6, 16, micro_u8s8_6x16          , micro_u8s8_6x16_narrow },
+    { "scalar"    ,  4,  8, micro_u8s8_generic<4, 8> , nullptr                },
+};
+
+bool supported(const ikernel_t & ker)
+{
+    __builtin_cpu_init();
+
+    std::string name = ker.name;
+    if (name == "avx512vnni")
+        return __builtin_cpu_supports("avx512f")
+            && __builtin_cpu_supports("avx512vl")
+            && __builtin_cpu_supports("avx512bw")
+            && __builtin_cpu_supports("avx512dq")
+            && __builtin_cpu_supports("avx512vnni");
+    if (name == "avx2")
+        return __builtin_cpu_supports("avx2");
+    return true;
+}
+
+const ikernel_t * find_ikernel(const std::string & name) // nullptr if unknown or unsupported
+{
+    for (const ikernel_t & ker : ikernels)
+        if (name == ker.name)
+            return supported(ker) ? &ker : nullptr;
+    return nullptr;
+}
+
+const ikernel_t & ikernel() // best one for this CPU, chosen once
+{
+    static const ikernel_t & selected = []() -> const ikernel_t &
+    {
+        for (const ikernel_t & ker : ikernels)
+            if (supported(ker))
+                return ker;
+        return ikernels[std::size(ikernels) - 1];
+    }();
+    return selected;
+}
+
+// rows [0, M) of A into MR-row panels, k zero-padded up to a multiple of 4;
+// flip = 0x80 maps s8 to u8 (a + 128). A k group of a row is a 32-bit word and the panel is
+// the transpose of those words: 4 groups of 4 rows at a time by a 4 x 4 transpose of words
+void pack_a_u8(const uint8_t * A, int lda, int M, int K, int MR, uint8_t flip, uint8_t * bufA)
+{
+    const int K4 = (K + 3) / 4, K16 = K / 16;
+    const __m128i f = _mm_set1_epi8(char(flip));
+
+    for (int i = 0; i < M; i += MR, A += MR * lda)
+    {
+        int dM = std::min(M - i, MR);
+
+        for (int h = 0; h < K16; ++h)
+            for (int r0 = 0; r0 < MR; r0 += 4)
+            {
+                __m128i x[4];
+                for (int r = 0; r < 4; ++r)
+                    x[r] = r0 + r < dM ? _mm_xor_si128(_mm_loadu_si128((const __m128i *)(A + (r0 + r) * lda + 16 * h)), f) : _mm_setzero_si128();
+
+                __m128i t0 = _mm_unpacklo_epi32(x[0], x[1]), t1 = _mm_unpackhi_epi32(x[0], x[1]);
+                __m128i t2 = _mm_unpacklo_epi32(x[2], x[3]), t3 = _mm_unpackhi_epi32(x[2], x[3]);
+                __m128i g[4] = { _mm_unpacklo_epi64(t0, t2), _mm_unpackhi_epi64(t0, t2), _mm_unpacklo_epi64(t1, t3), _mm_unpackhi_epi64(t1, t3) };
+
+                const int n = std::min(4, MR - r0); // rows of the panel in this transpose
+                for (int q = 0; q < 4; ++q)
+                {
+                    uint8_t * dst = bufA + (4 * h + q) * MR * 4 + r0 * 4;
+                    if (n == 4)
+                        _mm_storeu_si128((__m128i *)dst, g[q]);
+                    else
+                    {
+                        alignas(16) uint8_t w[16];
+                        _mm_store_si128((__m128i *)w, g[q]);
+                        std::memcpy(dst, w, 4 * n);
+                    }
+                }
+            }
+
+        for (int g = 4 * K16; g < K4; ++g) // the last groups, the zero padding
+            for (int r = 0; r < MR; ++r)
+                for (int t = 0; t < 4; ++t)
+                {
+                    int k = g * 4 + t;
+                    bufA[g * MR * 4 + r * 4 + t] = r < dM && k < K ? A[r * lda + k] ^ flip : 0;
+                }
+
+        bufA += K4 * MR * 4;
+    }
+}
+
+// columns [0, N) of B into NR-wide micro-panels, one after another; a group interleaves
+// the bytes of its 4 rows column by column: 16 columns at a time by byte and word unpacks
+void pack_b_s8(int K, int N, const int8_t * B, int ldb, int NR, int8_t * bufB)
+{
+    const int K4 = (K + 3) / 4;
+
+    for (int j = 0; j < N; j += NR, B += NR)
+    {
+        int dN = std::min(N - j, NR);
+
+        for (int g = 0; g < K4; ++g, bufB += NR * 4)
+        {
+            int c = 0;
+            if (g * 4 + 4 <= K)
+                for (const int8_t * b = B + g * 4 * ldb; c + 16 <= dN; c += 16)
+                {
+                    __m128i r0 = _mm_loadu_si128((const __m128i *)(b + 0 * ldb + c));
+                    __m128i r1 = _mm_loadu_si128((const __m128i *)(b + 1 * ldb + c));
+                    __m128i r2 = _mm_loadu_si128((const __m128i *)(b + 2 * ldb + c));
+                    __m128i r3 = _mm_loadu_si128((const __m128i *)(b + 3 * ldb + c));
+
+                    __m128i lo01 = _mm_unpacklo_epi8(r0, r1), hi01 = _mm_unpackhi_epi8(r0, r1);
+                    __m128i lo23 = _mm_unpacklo_epi8(r2, r3), hi23 = _mm_unpackhi_epi8(r2, r3);
+
+                    _mm_storeu_si128((__m128i *)(bufB + c * 4 +  0), _mm_unpacklo_epi16(lo01, lo23));
+                    _mm_storeu_si128((__m128i *)(bufB + c * 4 + 16), _mm_unpackhi_epi16(lo01, lo23));
+                    _mm_storeu_si128((__m128i *)(bufB + c * 4 + 32), _mm_unpacklo_epi16(hi01, hi23));
+                    _mm_storeu_si128((__m128i *)(bufB + c * 4 + 48), _mm_unpackhi_epi16(hi01, hi23));
+                }
+
+            for (; c < NR; ++c) // the last columns, the zero padding
+                for (int t = 0; t < 4; ++t)
+                {
+                    int k = g * 4 + t;
+                    bufB[c * 4 + t] = c < dN && k < K ? B[k * ldb + c] : 0;
+                }
+        }
+    }
+}
+
+// Requantization of the int32 product, per row of A and per column of B:
+// real A[i][k] = a_scale[i] * (A[i][k] - a_zero[i]), real B[k][j] = b_scale[j] * (B[k][j] - b_zero[j]),
+// u8 C[i][j] = clamp(round(real C[i][j] / c_scale) + c_zero, 0, 255); null zero points are 0
+struct quant_t
+{
+    const float   * a_scale; // M
+    const int32_t * a_zero;  // M or nullptr
+    const float   * b_scale; // N
+    const int32_t * b_zero;  // N or nullptr
+    float   c_scale;
+    int32_t c_zero;
+};
+
+namespace detail
+{
+
+// every |b| <= 64: the kernel's micro_narrow cannot saturate
+bool narrow(int K, int N, const int8_t * B, int ldb)
+{
+    for (int k = 0; k < K; ++k)
+        for (int j = 0; j < N; ++j)
+            if (B[k * ldb + j] < -64 || B[k * ldb + j] > 64)
+                return false;
+    return true;
+}
+
+// Loop nest of gemm.h over 4-byte k groups, accumulating into the int32 C (M x N);
+// the blocks of A by chunks of B micro-panels go to the pool as in detail::blocked.
+// init(i, dM, j, dN) sets a block of C before its first K block, done(i, dM, j, dN) gets it after the last
+template<typename TA, typename Init, typename Done>
+void igemm( int M, int N, int K
+          , const TA     * A, int lda
+          , const int8_t * B, int ldb
+          , int32_t * C, int ldc
+          , const ikernel_t & ker
+          , ThreadPool * pool
+          , Init && init
+          , Done && done
+          )
+{
+    if (K <= 0)
+    {
+        init(0, M, 0, N);
+        return done(0, M, 0, N);
+    }
+
+    const int MR = ker.MR
+            , NR = ker.NR;
+    const uint8_t flip = std::is_signed_v<TA> ? 0x80 : 0x00;
+    const auto micro = ker.micro_narrow && narrow(K, N, B, ldb) ? ker.micro_narrow : ker.micro;
+
+    // same budgets as make_blocking, counted in bytes of packed B
+    const cache_t & cache = caches();
+    const int mK = std::max(4, std::min(cache.L1.size / NR, (K + 3) / 4 * 4) / 4 * 4);
+    const int mM = std::min(std::max(MR, cache.L2.size / mK / MR * MR), M);
+    const int mN = std::min(std::max(NR, cache.L3.size / mK / NR * NR), N);
+
+    const int nI = (M + mM - 1) / mM;
+    const int P  = pool ? std::max(1u, pool->size()) : 1;
+    const int tN = std::min((P + nI - 1) / nI, (mN + NR - 1) / NR); // chunks of micro-panels
+    const int T  = std::min(P, nI * tN);
+
+    std::vector<int8_t> bufB(std::size_t(mK) * ((mN + NR - 1) / NR * NR));
+    std::vector<std::vector<uint8_t>> bufA(T, std::vector<uint8_t>(std::size_t(mK) * ((mM + MR - 1) / MR * MR)));
+
+    for (int j = 0; j < N; j += mN) // cycle 6: macro for B
+    {
+        const int dN = std::min(N, j + mN) - j;
+        const int nS = (dN + NR - 1) / NR;
+
+        for (int k = 0; k < K; k += mK) // cycle 5: macro for A и B
+        {
+            const int dK = std::min(K, k + mK) - k;
+            const int K4 = (dK + 3) / 4;
+
+            parallel_for(pool, T, [&](int t) // reorder B, split by micro-panels
+            {
+                const int s0 = nS * t / T, s1 = nS * (t + 1) / T;
+                if (s0 < s1)
+                    pack_b_s8(dK, std::min(dN, s1 * NR) - s0 * NR, B + k * ldb + j + s0 * NR, ldb, NR, bufB.data() + s0 * NR * K4 * 4);
+            });
+
+            parallel_for(pool, T, [&](int t) // cycle 4, by (block of A, chunk of micro-panels)
+            {
+                uint8_t * pA = bufA[t].data();
+
+                for (int w = t; w < nI * tN; w += T)
+                {
+                    const int i  = w / tN * mM, dM = std::min(M - i, mM);
+                    const int s0 = nS * (w % tN) / tN, s1 = nS * (w % tN + 1) / tN;
+                    const int jc = j + s0 * NR, dC = std::min(dN, s1 * NR) - s0 * NR;
+                    if (dC <= 0)
+                        continue;
+
+                    if (k == 0)
+                        init(i, dM, jc, dC);
+
+                    pack_a_u8(reinterpret_cast<const uint8_t *>(A) + i * lda + k, lda, dM, dK, MR, flip, pA);
+
+                    for (int jr = 0; jr < dC; jr += NR) // cycle 3
+                    for (int ir = 0; ir < dM; ir += MR) // cycle 2
+                    {
+                        const uint8_t * a = pA + ir * K4 * 4;
+                        const  int8_t * b = bufB.data() + (s0 * NR + jr) * K4 * 4;
+                        int32_t * pC = C + (i + ir) * ldc + jc + jr;
+
+                        if (ir + MR <= dM && jr + NR <= dC)
+                            micro(K4, a, b, pC, ldc);
+                        else
+                        {
+                            alignas(64) int32_t tile[14 * 32] = {};
+                            micro(K4, a, b, tile, NR);
+
+                            for (int r = 0; r < std::min(MR, dM - ir); ++r)
+                                for (int c = 0; c < std::min(NR, dC - jr); ++c)
+                                    pC[r * ldc + c] += tile[r * NR + c];
+                        }
+                    }
+
+                    if (k + dK >= K)
+                        done(i, dM, jc, dC);
+                }
+            });
+        }
+    }
+}
+
+template<typename T>
+std::vector<int32_t> row_sums(int M, int K, const T * A, int lda)
+{
+    std::vector<int32_t> s(M);
+    for (int i = 0; i < M; ++i)
+        for (int k = 0; k < K; ++k)
+            s[i] += A[i * lda + k];
+    return s;
+}
+
+std::vector<int32_t> col_sums(int K, int N, const int8_t * B, int ldb)
+{
+    std::vector<int32_t> s(N);
+    for (int k = 0; k < K; ++k)
+        for (int j = 0; j < N; ++j)
+            s[j] += B[k * ldb + j];
+    return s;
+}
+
+// C is the accumulator itself, preset to the correction of the flip
+template<typename TA>
+void gemm_s32( int M, int N, int K
+             , const TA     * A, int lda
+             , const int8_t * B, int ldb
+             , int32_t * C, int ldc
+             , const ikernel_t & ker
+             , ThreadPool * pool
+             )
+{
+    if (M <= 0 || N <= 0)
+        return;
+
+    std::vector<int32_t> colB = std::is_signed_v<TA> ? col_sums(K, N, B, ldb) : std::vector<int32_t>(N);
+
+    igemm(M, N, K, A, lda, B, ldb, C, ldc, ker, pool, [&](int i, int dM, int j, int dN)
+    {
+        for (int r = i; r < i + dM; ++r)
+            for (int c = j; c < j + dN; ++c)
+                C[r * ldc + c] = -128 * colB[c];
+    },
+    [](int, int, int, int) {});
+}
+
+// TC is uint8_t (requantized) or float (dequantized, c_scale and c_zero unused);
+// the int32 product goes through a workspace W, M x N, converted block by block
+template<typename TA, typename TC>
+void qgemm( int M, int N, int K
+          , const TA     * A, int lda
+          , const int8_t * B, int ldb
+          , const quant_t & q
+          , TC * C, int ldc
+          , const ikernel_t & ker
+          , ThreadPool * pool
+          )
+{
+    if (M <= 0 || N <= 0)
+        return;
+
+    std::vector<int32_t> rowA = row_sums(M, K, A, lda);
+    std::vector<int32_t> colB = col_sums(K, N, B, ldb);
+    std::vector<int32_t> W(std::size_t(M) * N); // zeroed here, nothing to set before the first K block
+    std::vector<int32_t> noZeroB(q.b_zero ? 0 : N); // loaded in place of a null b_zero, no branch in the loop
+
+    igemm(M, N, K, A, lda, B, ldb, W.data(), N, ker, pool, [](int, int, int, int) {},
+    [&](int i, int dM, int j, int dN)
+    {
+        // locals, not q. and vector members: stores to u8 C may alias anything and would reload them
+        const int32_t * const zeroB  = q.b_zero ? q.b_zero : noZeroB.data();
+        const float   * const scaleB = q.b_scale;
+        const int32_t * const sumB   = colB.data();
+        const float   cScale = q.c_scale;
+        const int32_t cZero  = q.c_zero;
+
+        for (int r = i; r < i + dM; ++r)
+        {
+            const int32_t za   = q.a_zero ? q.a_zero[r] : 0;
+            const int32_t zaB  = std::is_signed_v<TA> ? 128 + za : za;
+            const int32_t sumA = rowA[r] - K * za;
+            const float   sa   = q.a_scale[r];
+            const int32_t * const w = W.data() + r * N;
+            TC * const out = C + r * ldc;
+
+            // sum (a - za)(b - zb) = sum ab - za sum b - zb sum a + K za zb, flipped A adds 128 sum b;
+            // straight-line, the column loops over it vectorize
+            auto const real = [&](int c)
+            {
+                const int32_t acc = w[c] - zaB * sumB[c] - zeroB[c] * sumA;
+                return sa * scaleB[c] * float(acc);
+            };
+
+            if constexpr (std::is_same_v<TC, float>)
+                for (int c = j; c < j + dN; ++c)
+                    out[c] = real(c);
+            else
+            {
+                // 64 columns at a time through t, the rounding of cvtps is lrintf's (half to even),
+                // the saturating packs clamp to u8; t is clamped to 2^24, integral beyond, first to stay in int32
+                alignas(16) float t[64];
+                for (int c0 = j; c0 < j + dN; c0 += 64)
+                {
+                    const int n = std::min(64, j + dN - c0);
+                    for (int c = 0; c < n; ++c)
+                        t[c] = real(c0 + c) / cScale;
+
+                    int c = 0;
+                    for (; c + 4 <= n; c += 4)
+                    {
+                        __m128  v = _mm_min_ps(_mm_max_ps(_mm_load_ps(t + c), _mm_set1_ps(-16777216.f)), _mm_set1_ps(16777216.f));
+                        __m128i x = _mm_add_epi32(_mm_cvtps_epi32(v), _mm_set1_epi32(cZero));
+                        x = _mm_packus_epi16(_mm_packs_epi32(x, x), x);
+                        const int32_t four = _mm_cvtsi128_si32(x);
+                        std::memcpy(out + c0 + c, &four, 4);
+                    }
+                    for (; c < n; ++c)
+                        out[c0 + c] = uint8_t(std::clamp(int32_t(std::lrintf(std::clamp(t[c], -16777216.f, 16777216.f))) + cZero, 0, 255));
+                }
+            }
+        }
+    });
+}
+
+} // namespace detail
+
+// Row-major C = A * B accumulated in int32; pool == nullptr runs inline
+void gemm_u8s8s32( int M, int N, int K
+                 , const uint8_t * A, int lda
+                 , const  int8_t * B, int ldb
+                 ,       int32_t * C, int ldc
+                 , const ikernel_t & ker = ikernel()
+                 , ThreadPool * pool = nullptr
+                 )
+{
+    detail::gemm_s32(M, N, K, A, lda, B, ldb, C, ldc, ker, pool);
+}
+
+void gemm_s8s8s32( int M, int N, int K
+                 , const  int8_t * A, int lda
+                 , const  int8_t * B, int ldb
+                 ,       int32_t * C, int ldc
+                 , const ikernel_t & ker = ikernel()
+                 , ThreadPool * pool = nullptr
+                 )
+{
+    detail::gemm_s32(M, N, K, A, lda, B, ldb, C, ldc, ker, pool);
+}
+
+// Quantized C = A * B with the zero points removed and the scales applied, see quant_t
+void qgemm( int M, int N, int K
+          , const uint8_t * A, int lda
+          , const  int8_t * B, int ldb
+          , const quant_t & q
+          ,       uint8_t * C, int ldc
+          , ThreadPool * pool = nullptr
+          )
+{
+    detail::qgemm(M, N, K, A, lda, B, ldb, q, C, ldc, ikernel(), pool);
+}
+
+void qgemm( int M, int N, int K
+          , const  int8_t * A, int lda
+          , const  int8_t * B, int ldb
+          , const quant_t & q
+          ,       uint8_t * C, int ldc
+          , ThreadPool * pool = nullptr
+          )
+{
+    detail::qgemm(M, N, K, A, lda, B, ldb, q, C, ldc, ikernel(), pool);
+}
+
+// dequantized to fp32
+void qgemm( int M, int N, int K
+          , const uint8_t * A, int lda
+          , const  int8_t * B, int ldb
+          , const quant_t & q
+          ,         float * C, int ldc
+          , ThreadPool * pool = nullptr
+          )
+{
+    detail::qgemm(M, N, K, A, lda, B, ldb, q, C, ldc, ikernel(), pool);
+}
+
+void qgemm( int M, int N, int K
+          , const  int8_t * A, int lda
+          , const  int8_t * B, int ldb
+          , const quant_t & q
+          ,         float * C, int ldc
+          , ThreadPool * pool = nullptr
+          )
+{
+    detail::qgemm(M, N, K, A, lda, B, ldb, q, C, ldc, ikernel(), pool);
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <vector>
+
+// K-split for shapes whose C alone cannot feed the threads (e.g. 64 x 64 with K of a million):
+// each of P parts runs the serial sgemm over its own range of K, part 0 straight into C with beta,
+// the others into private M x N partials, which are then added to C by row ranges in parallel
+
+// parts of K for the shape on `threads` workers, 1 - C has enough parallelism of its own
+int ksplit_parts(int M, int N, int K, int threads, const kernel_t & ker = kernel())
+{
+    const int T = std::max(1, threads);
+    const blocking_t b = make_blocking(M, N, K, T, ker);
+
+    // tasks the parallel sgemm can make: M blocks of cycle 4 times B micro-panels of cycle 3
+    const long tasks = long((M + b.mM - 1) / b.mM) * ((std::min(N, b.mN) + ker.NR - 1) / ker.NR);
+    if (T == 1 || tasks >= T)
+        return 1;
+
+    // a part is kept well above its share of the reduction: M x N x K / P FMAs against M x N adds
+    const int minK = 4 * ker.NR * ker.MR;
+    return std::max(1, std::min(T, K / minK));
+}
+
+// Workspace of a K-split: serial blocking and packing buffers of each part, partials of parts 1..P-1
+struct ksplit_t
+{
+    int parts;
+    blocking_t blocking;
+    std::vector<buf_t> bufB, bufA;
+    buf_t partial;
+    int ldp;
+};
+
+ksplit_t make_ksplit(int M, int N, int K, int parts, const kernel_t & ker = kernel())
+{
+    const int P   = std::max(1, parts);
+    const int ldp = (N + 15) / 16 * 16;
+
+    ksplit_t ws = { P, make_blocking(M, N, (K + P - 1) / P, 1, ker), {}, {}, buf_t(std::max(1, (P - 1) * M * ldp)), ldp };
+
+    if (P == 1) // not split, nothing to allocate
+        return ws;
+
+    ws.bufB.reserve(P);
+    ws.bufA.reserve(P);
+    for (int p = 0; p < P; ++p)
+    {
+        ws.bufB.emplace_back(bufB_size(ws.blocking));
+        ws.bufA.emplace_back(bufA_size(ws.blocking));
+    }
+    return ws;
+}
+
+template<typename Epi>
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , ksplit_t & ws
+          , ThreadPool & pool
+          , const Epi & epi
+          )
+{
+    if (M <= 0 || N <= 0)
+        return;
+    const kernel_t & ker = *ws.blocking.ker;
+
+    if (K <= 0 || alpha == 0.f)
+    {
+        ker.init_c(M, N, C, ldc, beta);
+        return apply_epilogue(M, N, C, ldc, epi);
+    }
+
+    const int P = ws.parts;
+    const int T = std::max(1u, pool.size());
+
+    for (int p = 0; p < P; ++p) // partial products over K ranges
+        pool.enqueue([=, &ker, &ws] noexcept
+        {
+            int k  = long(K) *  p      / P;
+            int dK = long(K) * (p + 1) / P - k;
+
+            float * pC = p == 0 ? C   : ws.partial.p + long(p - 1) * M * ws.ldp;
+            int     lc = p == 0 ? ldc : ws.ldp;
+
+            if (dK <= 0)
+                return ker.init_c(M, N, pC, lc, p == 0 ? beta : 0.f);
+
+            sgemm
+            (
+                transA, transB, M, N, dK,
+                alpha, at(transA, A, lda, 0, k), lda,
+                       at(transB, B, ldb, k, 0), ldb,
+                p == 0 ? beta : 0.f, pC, lc,
+                ws.blocking, ws.bufB[p], ws.bufA[p]
+            );
+        });
+    pool.wait();
+
+
+    for (int t = 0; t < T; ++t) // reduction and the epilogue, by rows of C
+        pool.enqueue([=, &ker, &ws, &epi] noexcept
+        {
+            int i  = long(M) *  t      / T;
+            int dM = long(M) * (t + 1) / T - i;
+            if (dM <= 0)
+                return;
+
+            for (int p = 1; p < P; ++p)
+                ker.add_c(dM, N, ws.partial.p + long(p - 1) * M * ws.ldp + long(i) * ws.ldp, ws.ldp, C + long(i) * ldc, ldc);
+
+            apply_epilogue(dM, N, C + long(i) * ldc, ldc, epi, i, 0);
+        });
+    pool.wait();
+}
+
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , ksplit_t & ws
+          , ThreadPool & pool
+          )
+{
+    sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, ws, pool, epi_none());
+}
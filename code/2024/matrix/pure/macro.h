@@ -1,21 +1,85 @@
-void macro( int M, int N, int K
+void macro( const kernel_t & ker
+          , int M, int N, int K
           , const float * A
-          , const float * B, int ldb, float * bufB, bool reorderB
+          , char transB, const float * B, int ldb, float * bufB, bool reorderB
           ,       float * C, int ldc
           )
 {
-    for (int j = 0; j < N; j += 16) // cycle 3: micro по reordered B (in L3),
+    const int MR = ker.MR
+            , NR = ker.NR;
+
+    for (int j = 0; j < N; j += NR) // cycle 3: micro по reordered B (in L3),
                                     // optionally reorder rest of  B
     {
+        int dN = std::min(N - j, NR);
+
         if(reorderB)
-            reorder_b_16(K, B + j, ldb,  bufB + K * j);
-
-        for (int i = 0; i < M; i += 6) // cycle 2: micro по reordered A (in L2)
-              micro_6x16
-              (
-                  K, A + i * K, 1, 6, 
-                  bufB + K * j,  16, 
-                  C + i * ldc + j, ldc
-              );
+            ker.pack_b(transB, K, dN, at(transB, B, ldb, 0, j), ldb, bufB + K * j);
+
+        for (int i = 0; i < M; i += MR) // cycle 2: micro по reordered A (in L2)
+            if (dN == NR && i + MR <= M)
+                ker.micro
+                (
+                    K,
+                    A + i * K,
+                    bufB + K * j,
+                    C + i * ldc + j, ldc
+                );
+            else
+                ker.micro_tail
+                (
+                    std::min(M - i, MR), dN, K,
+                    A + i * K,
+                    bufB + K * j,
+                    C + i * ldc + j, ldc
+                );
+    }
+}
+
+// The last K block: C = epi(C + A * B), (i0, j0) is the corner of this block in the whole C.
+// Full tiles go through the fused kernel, edges through a local tile and the float epilogue
+template<typename Epi>
+void macro( const kernel_t & ker
+          , int M, int N, int K
+          , const float * A
+          , char transB, const float * B, int ldb, float * bufB, bool reorderB
+          ,       float * C, int ldc
+          , const Epi & epi, int i0, int j0
+          )
+{
+    if constexpr (std::is_same_v<Epi, epi_none>)
+        return macro(ker, M, N, K, A, transB, B, ldb, bufB, reorderB, C, ldc);
+
+    const int MR = ker.MR
+            , NR = ker.NR;
+    const micro_epi_t<Epi> fused = micro_epi<Epi>(ker);
+
+    for (int j = 0; j < N; j += NR) // cycle 3
+    {
+        int dN = std::min(N - j, NR);
+
+        if(reorderB)
+            ker.pack_b(transB, K, dN, at(transB, B, ldb, 0, j), ldb, bufB + K * j);
+
+        for (int i = 0; i < M; i += MR) // cycle 2
+            if (fused && dN == NR && i + MR <= M)
+                fused
+                (
+                    K,
+                    A + i * K,
+                    bufB + K * j,
+                    C + i * ldc + j, ldc,
+                    epi, i0 + i, j0 + j
+                );
+            else
+            {
+                alignas(64) float tile[14 * 32] = {};
+                ker.micro(K, A + i * K, bufB + K * j, tile, NR);
+
+                float * pC = C + i * ldc + j;
+                for (int r = 0; r < std::min(M - i, MR); ++r)
+                    for (int c = 0; c < dN; ++c)
+                        pC[r * ldc + c] = epi(pC[r * ldc + c] + tile[r * NR + c], i0 + i + r, j0 + j + c);
+            }
     }
 }
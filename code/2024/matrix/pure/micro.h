@@ -1,7 +1,10 @@
-void micro_6x16( int K, int step
-               , const float * A, int lda
-               , const float * B, int ldb, float * C, int ldc
-               )
+// C = epi(C + A * B) for the 6x16 tile at row i, column j of the whole C, see epilogue.h
+template<typename Epi>
+AVX2 void micro_6x16( int K, int step
+                    , const float * A, int lda
+                    , const float * B, int ldb, float * C, int ldc
+                    , const Epi & epi, int i, int j
+                    )
 {
     __m256 c00 = _mm256_setzero_ps();
     __m256 c10 = _mm256_setzero_ps();
@@ -16,6 +19,12 @@ void micro_6x16( int K, int step
     __m256 c41 = _mm256_setzero_ps();
     __m256 c51 = _mm256_setzero_ps();
 
+    for (int r = 0; r < 6; ++r) // C is only touched after the k loop: fetch it while the FMAs run
+    {
+        _mm_prefetch((const char *)(C + r * ldc +  0), _MM_HINT_T0);
+        _mm_prefetch((const char *)(C + r * ldc + 15), _MM_HINT_T0);
+    }
+
     const int offset0 = lda * 0;
     const int offset1 = lda * 1;
     const int offset2 = lda * 2;
@@ -72,36 +81,66 @@ void micro_6x16( int K, int step
         
         B += ldb; A += step;
     }
-    _mm256_storeu_ps(C + 0, _mm256_add_ps(c00, _mm256_loadu_ps(C + 0)));
-    _mm256_storeu_ps(C + 8, _mm256_add_ps(c01, _mm256_loadu_ps(C + 8)));
+    _mm256_storeu_ps(C + 0, epi(_mm256_add_ps(c00, _mm256_loadu_ps(C + 0)), i + 0, j + 0));
+    _mm256_storeu_ps(C + 8, epi(_mm256_add_ps(c01, _mm256_loadu_ps(C + 8)), i + 0, j + 8));
     C += ldc;
 
    //-------------------------------------------------------------------//
 
-    _mm256_storeu_ps(C + 0, _mm256_add_ps(c10, _mm256_loadu_ps(C + 0)));
-    _mm256_storeu_ps(C + 8, _mm256_add_ps(c11, _mm256_loadu_ps(C + 8)));
+    _mm256_storeu_ps(C + 0, epi(_mm256_add_ps(c10, _mm256_loadu_ps(C + 0)), i + 1, j + 0));
+    _mm256_storeu_ps(C + 8, epi(_mm256_add_ps(c11, _mm256_loadu_ps(C + 8)), i + 1, j + 8));
     C += ldc;
 
    //-------------------------------------------------------------------//
    
-    _mm256_storeu_ps(C + 0, _mm256_add_ps(c20, _mm256_loadu_ps(C + 0)));
-    _mm256_storeu_ps(C + 8, _mm256_add_ps(c21, _mm256_loadu_ps(C + 8)));
+    _mm256_storeu_ps(C + 0, epi(_mm256_add_ps(c20, _mm256_loadu_ps(C + 0)), i + 2, j + 0));
+    _mm256_storeu_ps(C + 8, epi(_mm256_add_ps(c21, _mm256_loadu_ps(C + 8)), i + 2, j + 8));
     C += ldc;
 
    //-------------------------------------------------------------------//
 
-    _mm256_storeu_ps(C + 0, _mm256_add_ps(c30, _mm256_loadu_ps(C + 0)));
-    _mm256_storeu_ps(C + 8, _mm256_add_ps(c31, _mm256_loadu_ps(C + 8)));
+    _mm256_storeu_ps(C + 0, epi(_mm256_add_ps(c30, _mm256_loadu_ps(C + 0)), i + 3, j + 0));
+    _mm256_storeu_ps(C + 8, epi(_mm256_add_ps(c31, _mm256_loadu_ps(C + 8)), i + 3, j + 8));
     C += ldc;
 
    //-------------------------------------------------------------------//
 
-    _mm256_storeu_ps(C + 0, _mm256_add_ps(c40, _mm256_loadu_ps(C + 0)));
-    _mm256_storeu_ps(C + 8, _mm256_add_ps(c41, _mm256_loadu_ps(C + 8)));
+    _mm256_storeu_ps(C + 0, epi(_mm256_add_ps(c40, _mm256_loadu_ps(C + 0)), i + 4, j + 0));
+    _mm256_storeu_ps(C + 8, epi(_mm256_add_ps(c41, _mm256_loadu_ps(C + 8)), i + 4, j + 8));
     C += ldc;
 
    //-------------------------------------------------------------------//
 
-    _mm256_storeu_ps(C + 0, _mm256_add_ps(c50, _mm256_loadu_ps(C + 0)));
-    _mm256_storeu_ps(C + 8, _mm256_add_ps(c51, _mm256_loadu_ps(C + 8)));
+    _mm256_storeu_ps(C + 0, epi(_mm256_add_ps(c50, _mm256_loadu_ps(C + 0)), i + 5, j + 0));
+    _mm256_storeu_ps(C + 8, epi(_mm256_add_ps(c51, _mm256_loadu_ps(C + 8)), i + 5, j + 8));
+}
+
+AVX2 void micro_6x16( int K, int step
+                    , const float * A, int lda
+                    , const float * B, int ldb, float * C, int ldc
+                    )
+{
+    micro_6x16(K, step, A, lda, B, ldb, C, ldc, epi_none(), 0, 0);
+}
+
+
+AVX2 void micro_6x16_tail( int M, int N, int K // M <= 6, N <= 16
+                         , const float * A
+                         , const float * B
+                         ,       float * C, int ldc
+                         )
+{
+    // packed A and B are zero-padded up to 6x16, so the full kernel is run
+    // into a local tile and only the valid M x N part is added to C
+    alignas(32) float tile[6 * 16] = {};
+    micro_6x16(K, 6, A, 1, B, 16, tile, 16);
+
+    const __m256i m0 = mask_8(N - 0);
+    const __m256i m1 = mask_8(N - 8);
+
+    for (int i = 0; i < M; ++i, C += ldc)
+    {
+        _mm256_maskstore_ps(C + 0, m0, _mm256_add_ps(_mm256_load_ps(tile + i * 16 + 0), _mm256_maskload_ps(C + 0, m0)));
+        _mm256_maskstore_ps(C + 8, m1, _mm256_add_ps(_mm256_load_ps(tile + i * 16 + 8), _mm256_maskload_ps(C + 8, m1)));
+    }
 }
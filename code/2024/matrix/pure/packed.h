@@ -0,0 +1,247 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <vector>
+
+// Operands packed once for repeated products with the same matrix (constant weights):
+// every block of the loop nest in the layout the kernel reads, so gemm skips packing it.
+// Block (j, k) of B starts at j * K + k * dN rounded up to NR, block (i, k) of A likewise with MR
+
+struct packed_b_t
+{
+    int K, N;
+    blocking_t blocking; // ker, mK and mN fix the layout
+    buf_t buf;
+
+    int offset(int j, int k) const
+    {
+        const int NR = blocking.ker->NR;
+        const int dN = std::min(N, j + blocking.mN) - j;
+        return j * K + k * ((dN + NR - 1) / NR * NR);
+    }
+
+    const float * block(int j, int k) const { return buf.p + offset(j, k); }
+};
+
+struct packed_a_t
+{
+    int M, K;
+    blocking_t blocking; // ker, mK and mM fix the layout; alpha is already applied
+    buf_t buf;
+
+    int offset(int i, int k) const
+    {
+        const int MR = blocking.ker->MR;
+        const int dM = std::min(M, i + blocking.mM) - i;
+        return i * K + k * ((dM + MR - 1) / MR * MR);
+    }
+
+    const float * block(int i, int k) const { return buf.p + offset(i, k); }
+};
+
+// op(B) is K x N; threads is what the later products will run on, it only tunes the blocks
+packed_b_t pack_b( char transB, int K, int N
+                 , const float * B, int ldb
+                 , unsigned int threads = 1
+                 , const kernel_t & ker = kernel()
+                 )
+{
+    const int NR = ker.NR;
+    packed_b_t packed { K, N, make_blocking(1, N, K, threads, ker), buf_t((N + NR - 1) / NR * NR * K) };
+    const auto [mK, mM, mN, tM, tN, _] = packed.blocking;
+
+    for (int j = 0; j < N; j += mN)
+    for (int k = 0; k < K; k += mK)
+    {
+        int dN = std::min(N, j + mN) - j;
+        int dK = std::min(K, k + mK) - k;
+        float * dst = packed.buf.p + packed.offset(j, k);
+
+        for (int s = 0; s < dN; s += NR)
+            ker.pack_b(transB, dK, std::min(dN - s, NR), at(transB, B, ldb, k, j + s), ldb, dst + dK * s);
+    }
+    return packed;
+}
+
+// op(A) is M x K, scaled by alpha once here
+packed_a_t pack_a( char transA, int M, int K
+                 , float alpha, const float * A, int lda
+                 , const kernel_t & ker = kernel()
+                 )
+{
+    const int MR = ker.MR;
+    packed_a_t packed { M, K, make_blocking(M, 1, K, 1, ker), buf_t((M + MR - 1) / MR * MR * K) };
+    const auto [mK, mM, mN, tM, tN, _] = packed.blocking;
+
+    for (int i = 0; i < M; i += mM)
+    for (int k = 0; k < K; k += mK)
+    {
+        int dM = std::min(M, i + mM) - i;
+        int dK = std::min(K, k + mK) - k;
+
+        ker.pack_a(transA, at(transA, A, lda, i, k), lda, dM, dK, alpha, packed.buf.p + packed.offset(i, k));
+    }
+    return packed;
+}
+
+namespace detail
+{
+
+// The loop nest of parallel.h where either operand may come pre-packed;
+// pool == nullptr runs everything on the calling thread
+template<typename Epi>
+void sgemm_packed( char transA, char transB, int M, int N, int K
+                 , float alpha, const float * A, int lda, const packed_a_t * pA
+                 ,              const float * B, int ldb, const packed_b_t * pB
+                 , float beta ,       float * C, int ldc
+                 , ThreadPool * pool
+                 , const Epi & epi
+                 )
+{
+    if (M <= 0 || N <= 0)
+        return;
+
+    const kernel_t & ker = pA ? *pA->blocking.ker : pB ? *pB->blocking.ker : kernel();
+    assert(!pA || !pB || (pA->blocking.ker == pB->blocking.ker && pA->blocking.mK == pB->blocking.mK));
+
+    if (K <= 0 || (!pA && alpha == 0.f))
+    {
+        ker.init_c(M, N, C, ldc, beta);
+        return apply_epilogue(M, N, C, ldc, epi);
+    }
+
+    const int T  = pool ? std::max(1u, pool->size()) : 1;
+    const int NR = ker.NR;
+
+    // the packed layouts fix their blocks, the thread grid follows
+    blocking_t blocking = make_blocking(M, N, K, T, ker);
+    if (pB)
+    {
+        blocking.mK = pB->blocking.mK;
+        blocking.mN = pB->blocking.mN;
+    }
+    if (pA)
+    {
+        blocking.mK = pA->blocking.mK;
+        blocking.mM = pA->blocking.mM;
+        blocking.tM = std::min(blocking.tM, (M + blocking.mM - 1) / blocking.mM);
+        blocking.tN = std::max(1, T / blocking.tM);
+    }
+    const auto [mK, mM, mN, tM, tN, _] = blocking;
+
+    buf_t bufB(pB ? 0 : bufB_size(blocking));
+    std::vector<buf_t> bufA;
+    if (!pA)
+        for (int t = 0; t < tM * tN; ++t)
+            bufA.emplace_back(bufA_size(blocking));
+
+    auto run = [pool](int n, auto && task)
+    {
+        if (!pool)
+            for (int t = 0; t < n; ++t)
+                task(t);
+        else
+        {
+            for (int t = 0; t < n; ++t)
+                pool->enqueue([&task, t] noexcept { task(t); });
+            pool->wait();
+        }
+    };
+
+    for (int j = 0; j < N; j += mN) // cycle 6: macro for B
+    {
+        int dN = std::min(N, j + mN) - j;
+        int nS = (dN + NR - 1) / NR;
+
+
+        for (int k = 0; k < K; k += mK) // cycle 5: macro for A и B
+        {
+            int dK = std::min(K, k + mK) - k;
+
+            float * pBk = pB ? const_cast<float *>(pB->block(j, k)) : bufB.p; // only read, macro gets reorderB = false
+            if (!pB)
+                run(T, [&](int t)
+                {
+                    for (int s = nS * t / T; s < nS * (t + 1) / T; ++s)
+                        ker.pack_b
+                        (
+                            transB, dK, std::min(dN - s * NR, NR),
+                            at(transB, B, ldb, k, j + s * NR), ldb,
+                            bufB.p + dK * s * NR
+                        );
+                });
+
+
+            run(tM * tN, [&](int t)
+            {
+                const int tm = t / tN
+                        , tn = t % tN;
+
+                int s0 = nS *  tn      / tN;
+                int s1 = nS * (tn + 1) / tN;
+                int dS = std::min(dN, s1 * NR) - s0 * NR;
+                if (dS <= 0)
+                    return;
+
+                for (int i = tm * mM; i < M; i += tM * mM) // cycle 4: macro for A, reorder A unless packed
+                {
+                    int dM = std::min(M, i + mM) - i;
+                    float * pC = C + i * ldc + j + s0 * NR;
+
+
+                    if (k == 0)
+                        ker.init_c(dM, dS, pC, ldc, beta);
+
+
+                    const float * pAk = pA ? pA->block(i, k) : bufA[t].p;
+                    if (!pA)
+                        ker.pack_a(transA, at(transA, A, lda, i, k), lda, dM, dK, alpha, bufA[t].p);
+
+                    if (k + dK < K)
+                        macro(ker, dM, dS, dK, pAk, transB, nullptr, ldb, pBk + dK * s0 * NR, false, pC, ldc);
+                    else
+                        macro(ker, dM, dS, dK, pAk, transB, nullptr, ldb, pBk + dK * s0 * NR, false, pC, ldc, epi, i, j + s0 * NR);
+                }
+            });
+        }
+    }
+}
+
+} // namespace detail
+
+// C = epi(alpha * op(A) * B + beta * C), B pre-packed by pack_b
+template<typename Epi = epi_none>
+void sgemm( char transA, int M
+          , float alpha, const float * A, int lda
+          ,              const packed_b_t & B
+          , float beta ,       float * C, int ldc
+          , ThreadPool * pool = nullptr
+          , const Epi & epi = Epi()
+          )
+{
+    detail::sgemm_packed(transA, 'N', M, B.N, B.K, alpha, A, lda, nullptr, nullptr, 0, &B, beta, C, ldc, pool, epi);
+}
+
+// C = epi(A * op(B) + beta * C), A pre-packed (and scaled) by pack_a
+template<typename Epi = epi_none>
+void sgemm( const packed_a_t & A
+          , char transB, int N, const float * B, int ldb
+          , float beta ,              float * C, int ldc
+          , ThreadPool * pool = nullptr
+          , const Epi & epi = Epi()
+          )
+{
+    detail::sgemm_packed('N', transB, A.M, N, A.K, 1.f, nullptr, 0, &A, B, ldb, nullptr, beta, C, ldc, pool, epi);
+}
+
+// both pre-packed, for the same kernel and K
+template<typename Epi = epi_none>
+void sgemm( const packed_a_t & A
+          , const packed_b_t & B
+          , float beta , float * C, int ldc
+          , ThreadPool * pool = nullptr
+          , const Epi & epi = Epi()
+          )
+{
+    assert(A.K == B.K);
+    detail::sgemm_packed('N', 'N', A.M, B.N, A.K, 1.f, nullptr, 0, &A, nullptr, 0, &B, beta, C, ldc, pool, epi);
+}
@@ -0,0 +1,239 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <vector>
+
+namespace detail
+{
+
+// runs task(t) for t in [0, n), on the pool if there is one
+template<typename F>
+void parallel_for(ThreadPool * pool, int n, F && task)
+{
+    if (!pool || n <= 1)
+        for (int t = 0; t < n; ++t)
+            task(t);
+    else
+    {
+        for (int t = 0; t < n; ++t)
+            pool->enqueue([&task, t] noexcept { task(t); });
+        pool->wait();
+    }
+}
+
+// tasks for n independent rows or columns, each at least `grain` of them
+inline int tasks(ThreadPool * pool, int n, int grain)
+{
+    return pool ? std::max(1, std::min<int>(pool->size(), n / grain)) : 1;
+}
+
+} // namespace detail
+
+// Workspace: bufB holds two packed B panels (2 x mN x mK) shared by all tasks: the next panel
+//            is packed by pool tasks queued with the compute tasks of the current one, so each
+//            block ends in one barrier; with room for one panel only it is packed in a phase of its own;
+//            bufA holds tM * tN private packed A blocks (mM x mK);
+// epi is fused into the last K block as in the serial sgemm
+template<typename Epi>
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , const blocking_t & blocking
+          , buf_t & bufB
+          , std::vector<buf_t> & bufA
+          , ThreadPool & pool
+          , const Epi & epi
+          )
+{
+    if (M <= 0 || N <= 0)
+        return;
+    const kernel_t & ker = *blocking.ker;
+
+    if (K <= 0 || alpha == 0.f)
+    {
+        ker.init_c(M, N, C, ldc, beta);
+        return apply_epilogue(M, N, C, ldc, epi);
+    }
+
+    const auto [mK, mM, mN, tM, tN, _] = blocking;
+    const int  T     = std::max(1u, pool.size());
+    const int  NR    = ker.NR;
+    const int  panel = bufB_size(blocking);
+    const bool ahead = bufB.n >= 2 * panel;
+
+    auto pack = [&](int j, int k, float * buf) // reorder the B panel (j, k), split by micro-panels into T tasks
+    {
+        int dN = std::min(N, j + mN) - j, dK = std::min(K, k + mK) - k;
+        int nS = (dN + NR - 1) / NR;
+
+        for (int t = 0; t < T; ++t)
+            pool.enqueue([=, &ker] noexcept
+            {
+                for (int s = nS * t / T; s < nS * (t + 1) / T; ++s)
+                    ker.pack_b
+                    (
+                        transB, dK, std::min(dN - s * NR, NR),
+                        at(transB, B, ldb, k, j + s * NR), ldb,
+                        buf + dK * s * NR
+                    );
+            });
+    };
+
+    if (ahead)
+    {
+        pack(0, 0, bufB.p);
+        pool.wait();
+    }
+
+    for (int j = 0, b = 0; j < N; j += mN) // cycle 6: macro for B
+    {
+        int dN = std::min(N, j + mN) - j;
+        int nS = (dN + NR - 1) / NR; // micro-panels in the current B panel, last may be ragged
+
+
+        for (int k = 0; k < K; k += mK, ++b) // cycle 5: macro for A и B, b-th B panel
+        {
+            int dK = std::min(K, k + mK) - k;
+            float * pB = bufB.p + (ahead ? b % 2 * panel : 0);
+
+
+            if (!ahead)
+            {
+                pack(j, k, pB);
+                pool.wait();
+            }
+            else if (k + mK < K) // the next panel into the other half, queued first so it is never the tail
+                pack(j, k + mK, bufB.p + (b + 1) % 2 * panel);
+            else if (j + mN < N)
+                pack(j + mN, 0, bufB.p + (b + 1) % 2 * panel);
+
+
+            for (int tm = 0; tm < tM; ++tm)
+            for (int tn = 0; tn < tN; ++tn)
+                pool.enqueue([=, &ker, &bufA, &epi] noexcept
+                {
+                    float * pA = bufA[tm * tN + tn].p;
+
+                    int s0 = nS *  tn      / tN;
+                    int s1 = nS * (tn + 1) / tN;
+                    int dS = std::min(dN, s1 * NR) - s0 * NR;
+                    if (dS <= 0)
+                        return;
+
+                    for (int i = tm * mM; i < M; i += tM * mM) // cycle 4: macro for A and reorder A,
+                                                               //          optionally scale C by beta
+                    {
+                        int dM = std::min(M, i + mM) - i;
+                        float * pC = C + i * ldc + j + s0 * NR;
+
+
+                        if (k == 0)
+                            ker.init_c(dM, dS, pC, ldc, beta);
+
+
+                        ker.pack_a(transA, at(transA, A, lda, i, k), lda, dM, dK, alpha, pA);
+                        if (k + dK < K)
+                            macro
+                            (
+                                ker,
+                                dM, dS, dK,
+                                pA,
+                                transB, nullptr, ldb, pB + dK * s0 * NR, false,
+                                pC, ldc
+                            );
+                        else
+                            macro
+                            (
+                                ker,
+                                dM, dS, dK,
+                                pA,
+                                transB, nullptr, ldb, pB + dK * s0 * NR, false,
+                                pC, ldc,
+                                epi, i, j + s0 * NR
+                            );
+                    }
+                });
+            pool.wait();
+        }
+    }
+}
+
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , const blocking_t & blocking
+          , buf_t & bufB
+          , std::vector<buf_t> & bufA
+          , ThreadPool & pool
+          )
+{
+    sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA, pool, epi_none());
+}
+
+
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , ThreadPool & pool
+          )
+{
+    if (M <= 0 || N <= 0 || K <= 0 || alpha == 0.f)
+        return sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+
+    if (int parts = ksplit_parts(M, N, K, pool.size()); parts > 1)
+    {
+        ksplit_t ws = make_ksplit(M, N, K, parts);
+        return sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, ws, pool);
+    }
+
+    const blocking_t blocking = make_blocking(M, N, K, pool.size());
+
+    buf_t bufB(2 * bufB_size(blocking));
+    std::vector<buf_t> bufA;
+    bufA.reserve(blocking.tM * blocking.tN);
+    for (int t = 0; t < blocking.tM * blocking.tN; ++t)
+        bufA.emplace_back(bufA_size(blocking));
+
+    sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA, pool);
+}
+
+template<typename Epi>
+void sgemm( char transA, char transB, int M, int N, int K
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , const Epi & epi
+          , ThreadPool & pool
+          )
+{
+    if (M <= 0 || N <= 0 || K <= 0 || alpha == 0.f)
+        return sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, epi);
+
+    if (int parts = ksplit_parts(M, N, K, pool.size()); parts > 1)
+    {
+        ksplit_t ws = make_ksplit(M, N, K, parts);
+        return sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, ws, pool, epi);
+    }
+
+    const blocking_t blocking = make_blocking(M, N, K, pool.size());
+
+    buf_t bufB(2 * bufB_size(blocking));
+    std::vector<buf_t> bufA;
+    bufA.reserve(blocking.tM * blocking.tN);
+    for (int t = 0; t < blocking.tM * blocking.tN; ++t)
+        bufA.emplace_back(bufA_size(blocking));
+
+    sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA, pool, epi);
+}
+
+void gemm( int M, int N, int K
+         , const float * A
+         , const float * B
+         ,       float * C
+         , ThreadPool & pool
+         )
+{
+    sgemm('N', 'N', M, N, K, 1.f, A, K, B, N, 0.f, C, N, pool);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <thread>
+#include <vector>
+
+// Everything gemm() needs for one shape, made once and reused:
+// block sizes, packing buffers and the worker threads;
+// shapes with too little C for the threads are planned as a K-split, see ksplit.h
+class GemmPlan
+{
+
+public:
+
+    GemmPlan( int M, int N, int K
+            , unsigned int threads = std::thread::hardware_concurrency()
+            , const kernel_t & ker = kernel()
+            )
+    : M(M), N(N), K(K)
+    , blocking(make_blocking(M, N, K, threads, ker))
+    , pool(std::max(1u, threads))
+    , bufB(2 * bufB_size(blocking))
+    , split(make_ksplit(M, N, K, ksplit_parts(M, N, K, threads, ker), ker))
+    {
+        bufA.reserve(blocking.tM * blocking.tN);
+        for (int t = 0; t < blocking.tM * blocking.tN; ++t)
+            bufA.emplace_back(bufA_size(blocking));
+    }
+
+    GemmPlan(const GemmPlan &) = delete;
+
+    // C = A * B for the planned shape; not reentrant, one plan per caller thread
+    void operator()(const float * A, const float * B, float * C)
+    {
+        (*this)('N', 'N', 1.f, A, K, B, N, 0.f, C, N);
+    }
+
+    // sgemm for the planned shape, see defs.h
+    void operator()( char transA, char transB
+                   , float alpha, const float * A, int lda
+                   ,              const float * B, int ldb
+                   , float beta ,       float * C, int ldc
+                   )
+    {
+        (*this)(transA, transB, alpha, A, lda, B, ldb, beta, C, ldc, epi_none());
+    }
+
+    // with an epilogue fused into the store, see epilogue.h
+    template<typename Epi>
+    void operator()( char transA, char transB
+                   , float alpha, const float * A, int lda
+                   ,              const float * B, int ldb
+                   , float beta ,       float * C, int ldc
+                   , const Epi & epi
+                   )
+    {
+        if (split.parts > 1)
+            return sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, split, pool, epi);
+        sgemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA, pool, epi);
+    }
+
+    const blocking_t & params() const noexcept { return blocking; }
+    int                ksplit() const noexcept { return split.parts; } // parts of K, 1 - no split
+
+private:
+
+    int M, N, K;
+    blocking_t blocking;
+
+    ThreadPool pool;
+    buf_t bufB;
+    std::vector<buf_t> bufA;
+    ksplit_t split;
+};
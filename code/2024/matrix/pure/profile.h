@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+// Per-machine tuning written by `matrix autotune` and read once at startup,
+// "key value" per line, '#' starts a comment; zero or missing means "derive it"
+struct profile_t
+{
+    std::string kernel;         // micro-kernel name, empty: best one for the CPU
+    int mK = 0, mM = 0, mN = 0; // cache blocks, 0: from the detected caches
+    int tM = 0;                 // workers over M panels, 0: as many as the panels allow
+    int ProcessElemNo = 0;      // algo.cpp matmul register tile, 0: its default
+    int strassen = 0;           // min(M, N, K) from which Strassen–Winograd takes a level, 0: 4096
+};
+
+// GEMM_PROFILE=<path> or ./gemm.profile
+std::string profile_path()
+{
+    const char * env = std::getenv("GEMM_PROFILE");
+    return env ? env : "gemm.profile";
+}
+
+profile_t load_profile(const std::string & path)
+{
+    profile_t p;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line); )
+    {
+        std::istringstream ss(line.substr(0, line.find('#')));
+        std::string key;
+        if (!(ss >> key))
+            continue;
+
+        if      (key == "kernel"       ) ss >> p.kernel;
+        else if (key == "mK"           ) ss >> p.mK;
+        else if (key == "mM"           ) ss >> p.mM;
+        else if (key == "mN"           ) ss >> p.mN;
+        else if (key == "tM"           ) ss >> p.tM;
+        else if (key == "ProcessElemNo") ss >> p.ProcessElemNo;
+        else if (key == "strassen"     ) ss >> p.strassen;
+    }
+    return p;
+}
+
+bool save_profile(const profile_t & p, const std::string & path)
+{
+    std::ofstream out(path);
+    out << "# gemm profile, see pure/profile.h\n";
+    if (!p.kernel.empty())
+        out << "kernel "        << p.kernel        << "\n";
+    out << "mK "            << p.mK            << "\n"
+        << "mM "            << p.mM            << "\n"
+        << "mN "            << p.mN            << "\n"
+        << "tM "            << p.tM            << "\n"
+        << "ProcessElemNo " << p.ProcessElemNo << "\n"
+        << "strassen "      << p.strassen      << "\n";
+    return bool(out);
+}
+
+const profile_t & profile()
+{
+    static const profile_t loaded = load_profile(profile_path());
+    return loaded;
+}
+
+std::ostream & operator<<(std::ostream & os, const profile_t & p)
+{
+    return os << (p.kernel.empty() ? "auto" : p.kernel)
+              << " mK " << p.mK << " mM " << p.mM << " mN " << p.mN
+              << " tM " << p.tM << " ProcessElemNo " << p.ProcessElemNo
+              << " strassen " << p.strassen;
+}
@@ -1,4 +1,4 @@
-void reorder_b_16(int K, const float * B, int ldb, float * bufB)
+AVX2 void reorder_b_16(int K, const float * B, int ldb, float * bufB)
 {
     for (int k = 0; k < K; ++k, B += ldb, bufB += 16)
     {
@@ -8,19 +8,108 @@ void reorder_b_16(int K, const float * B, int ldb, float * bufB)
 }
 
 
-void reorder_a_6(const float * A, int lda, int M, int K, float * bufA)
+AVX2 void reorder_b_16_tail(int K, int N, const float * B, int ldb, float * bufB) // N < 16, rest is zero-padded
 {
+    const __m256i m0 = mask_8(N - 0);
+    const __m256i m1 = mask_8(N - 8);
+
+    for (int k = 0; k < K; ++k, B += ldb, bufB += 16)
+    {
+        _mm256_storeu_ps(bufB + 0, _mm256_maskload_ps(B + 0, m0));
+        _mm256_storeu_ps(bufB + 8, _mm256_maskload_ps(B + 8, m1));
+    }
+}
+
+
+AVX2 void transpose_8x8(__m256 * r) // in registers: r[i][j] <-> r[j][i]
+{
+    __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+    __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+    __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+    __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+    __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+    __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+
+    __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+    r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+
+AVX2 void reorder_b_16_t(int K, int N, const float * B, int ldb, float * bufB) // B is stored as N x K, N <= 16
+{
+    int k = 0;
+    if (N == 16)
+        for (; k + 8 <= K; k += 8, bufB += 8 * 16)
+            for (int h = 0; h < 16; h += 8)
+            {
+                __m256 r[8];
+                for (int c = 0; c < 8; ++c)
+                    r[c] = _mm256_loadu_ps(B + (h + c) * ldb + k);
+
+                transpose_8x8(r);
+
+                for (int q = 0; q < 8; ++q)
+                    _mm256_storeu_ps(bufB + q * 16 + h, r[q]);
+            }
+
+    for (; k < K; ++k, bufB += 16) // tail of K or ragged N, zero-padded up to 16
+        for (int c = 0; c < 16; ++c)
+            bufB[c] = c < N ? B[c * ldb + k] : 0.f;
+}
+
+
+AVX2 void reorder_b(char trans, int K, int N, const float * B, int ldb, float * bufB) // one micro-panel, N <= 16
+{
+    if (is_trans(trans))
+        reorder_b_16_t   (K, N, B, ldb, bufB);
+    else if (N == 16)
+        reorder_b_16     (K,    B, ldb, bufB);
+    else
+        reorder_b_16_tail(K, N, B, ldb, bufB);
+}
+
+
+AVX2 void reorder_a_6(const float * A, int lda, int M, int K, float * bufA, float alpha)
+{
+    const __m128 a = _mm_set1_ps(alpha);
+
     for (int i = 0; i < M; i += 6)
     {
-        for (int k = 0; k < K; k += 4)
+        if (M - i < 6) // tail rows: zero-padded up to 6
+        {
+            for (int k = 0; k < K; ++k, bufA += 6)
+                for (int r = 0; r < 6; ++r)
+                    bufA[r] = r < M - i ? alpha * A[r * lda + k] : 0.f;
+            break;
+        }
+
+        int k = 0;
+        for (; k + 4 <= K; k += 4)
         {
             const float * pA = A + k;
-            __m128 a0  = _mm_loadu_ps(pA + 0 * lda);
-            __m128 a1  = _mm_loadu_ps(pA + 1 * lda);
-            __m128 a2  = _mm_loadu_ps(pA + 2 * lda);
-            __m128 a3  = _mm_loadu_ps(pA + 3 * lda);
-            __m128 a4  = _mm_loadu_ps(pA + 4 * lda);
-            __m128 a5  = _mm_loadu_ps(pA + 5 * lda);
+            __m128 a0  = _mm_mul_ps(a, _mm_loadu_ps(pA + 0 * lda));
+            __m128 a1  = _mm_mul_ps(a, _mm_loadu_ps(pA + 1 * lda));
+            __m128 a2  = _mm_mul_ps(a, _mm_loadu_ps(pA + 2 * lda));
+            __m128 a3  = _mm_mul_ps(a, _mm_loadu_ps(pA + 3 * lda));
+            __m128 a4  = _mm_mul_ps(a, _mm_loadu_ps(pA + 4 * lda));
+            __m128 a5  = _mm_mul_ps(a, _mm_loadu_ps(pA + 5 * lda));
 
             __m128 a00 = _mm_unpacklo_ps(a0, a2);
             __m128 a01 = _mm_unpacklo_ps(a1, a3);
@@ -43,6 +132,35 @@ void reorder_a_6(const float * A, int lda, int M, int K, float * bufA)
             
             bufA += 24;
         }
+        for (; k < K; ++k, bufA += 6) // tail of K
+            for (int r = 0; r < 6; ++r)
+                bufA[r] = alpha * A[r * lda + k];
+
         A += 6 * lda;
     }
 }
+
+
+AVX2 void reorder_a_6_t(const float * A, int lda, int M, int K, float * bufA, float alpha) // A is stored as K x M
+{
+    const __m256  a  = _mm256_set1_ps(alpha);
+    const __m256i m6 = mask_8(6);
+
+    for (int i = 0; i < M; i += 6, A += 6)
+    {
+        const __m256i mi = mask_8(std::min(M - i, 6)); // tail rows are zero-padded up to 6
+
+        const float * pA = A;
+        for (int k = 0; k < K; ++k, pA += lda, bufA += 6)
+            _mm256_maskstore_ps(bufA, m6, _mm256_mul_ps(a, _mm256_maskload_ps(pA, mi)));
+    }
+}
+
+
+AVX2 void reorder_a(char trans, const float * A, int lda, int M, int K, float alpha, float * bufA)
+{
+    if (is_trans(trans))
+        reorder_a_6_t(A, lda, M, K, bufA, alpha);
+    else
+        reorder_a_6  (A, lda, M, K, bufA, alpha);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+// Portable kernel and packers: plain loops for the baseline target,
+// also used by wider kernels for their rarely hit paths
+
+template<int MR, int NR>
+void micro_generic(int K, const float * A, const float * B, float * C, int ldc)
+{
+    float c[MR][NR] = {};
+
+    for (int k = 0; k < K; ++k, A += MR, B += NR)
+        for (int i = 0; i < MR; ++i)
+            for (int j = 0; j < NR; ++j)
+                c[i][j] += A[i] * B[j];
+
+    for (int i = 0; i < MR; ++i, C += ldc)
+        for (int j = 0; j < NR; ++j)
+            C[j] += c[i][j];
+}
+
+// packed A and B are zero-padded up to MR x NR, so the full kernel is run
+// into a local tile and only the valid M x N part is added to C
+template<int MR, int NR, void (*micro)(int, const float *, const float *, float *, int)>
+void micro_tail_generic(int M, int N, int K, const float * A, const float * B, float * C, int ldc)
+{
+    alignas(64) float tile[MR * NR] = {};
+    micro(K, A, B, tile, NR);
+
+    for (int i = 0; i < M; ++i, C += ldc)
+        for (int j = 0; j < N; ++j)
+            C[j] += tile[i * NR + j];
+}
+
+template<int MR>
+void pack_a_generic(char trans, const float * A, int lda, int M, int K, float alpha, float * bufA)
+{
+    for (int i = 0; i < M; i += MR)
+    {
+        int dM = std::min(M - i, MR);
+
+        for (int k = 0; k < K; ++k, bufA += MR)
+            for (int r = 0; r < MR; ++r)
+                bufA[r] = r < dM ? alpha * *at(trans, A, lda, i + r, k) : 0.f;
+    }
+}
+
+template<int NR>
+void pack_b_generic(char trans, int K, int N, const float * B, int ldb, float * bufB)
+{
+    for (int k = 0; k < K; ++k, bufB += NR)
+        for (int c = 0; c < NR; ++c)
+            bufB[c] = c < N ? *at(trans, B, ldb, k, c) : 0.f;
+}
+
+void init_c_generic(int M, int N, float * C, int ldc, float beta) // C = beta * C, C is not read for beta == 0
+{
+    if (beta == 1.f)
+        return;
+
+    for (int i = 0; i < M; ++i, C += ldc)
+        for (int j = 0; j < N; ++j)
+            C[j] = beta == 0.f ? 0.f : beta * C[j];
+}
+
+void add_c_generic(int M, int N, const float * P, int ldp, float * C, int ldc) // C += P
+{
+    for (int i = 0; i < M; ++i, P += ldp, C += ldc)
+        for (int j = 0; j < N; ++j)
+            C[j] += P[j];
+}
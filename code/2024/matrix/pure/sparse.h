@@ -0,0 +1,308 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <algorithm>
+#include <vector>
+
+// Sparse x dense: C = alpha * A * op(B) + beta * C with A in CSR, or in blocked CSR of 4 x 1 blocks
+// (4 rows sharing a column, zero-filled), so that each load of B feeds 4 rows. op(B) is packed
+// once into 16-wide micro-panels, the reorder_b_16 layout; every non-zero broadcasts against
+// a panel row. The rows are split over the pool in ranges of equal non-zeros
+
+struct csr_t // M x K
+{
+    int M, K;
+    std::vector<int>   ptr; // M + 1, row r is [ptr[r], ptr[r + 1])
+    std::vector<int>   col;
+    std::vector<float> val;
+};
+
+struct bcsr_t // M x K in blocks of R x 1, row block b is [ptr[b], ptr[b + 1])
+{
+    static constexpr int R = 4;
+
+    int M, K;
+    std::vector<int>   ptr; // (M + R - 1) / R + 1
+    std::vector<int>   col;
+    std::vector<float> val; // R per block, zero for the rows not in the pattern
+};
+
+csr_t make_csr(int M, int K, const float * A, int lda) // the non-zeros of a dense A
+{
+    csr_t S = { M, K, { 0 }, {}, {} };
+    S.ptr.reserve(M + 1);
+
+    for (int r = 0; r < M; ++r, A += lda)
+    {
+        for (int c = 0; c < K; ++c)
+            if (A[c] != 0.f)
+            {
+                S.col.push_back(c);
+                S.val.push_back(A[c]);
+            }
+        S.ptr.push_back(int(S.col.size()));
+    }
+    return S;
+}
+
+bcsr_t make_bcsr(const csr_t & S)
+{
+    constexpr int R = bcsr_t::R;
+    bcsr_t B = { S.M, S.K, { 0 }, {}, {} };
+
+    std::vector<int> cols;
+    for (int r0 = 0; r0 < S.M; r0 += R)
+    {
+        const int r1 = std::min(S.M, r0 + R);
+
+        cols.assign(S.col.begin() + S.ptr[r0], S.col.begin() + S.ptr[r1]); // the union of the rows' patterns
+        std::sort(cols.begin(), cols.end());
+        cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+
+        const std::size_t b0 = B.col.size();
+        B.col.insert(B.col.end(), cols.begin(), cols.end());
+        B.val.resize(B.col.size() * R, 0.f);
+
+        for (int r = r0; r < r1; ++r)
+            for (int p = S.ptr[r]; p < S.ptr[r + 1]; ++p) // both sorted by column
+            {
+                const std::size_t b = b0 + (std::lower_bound(cols.begin(), cols.end(), S.col[p]) - cols.begin());
+                B.val[b * R + r - r0] = S.val[p];
+            }
+        B.ptr.push_back(int(B.col.size()));
+    }
+    return B;
+}
+
+void densify(const csr_t & S, float * A, int lda)
+{
+    for (int r = 0; r < S.M; ++r, A += lda)
+    {
+        std::fill(A, A + S.K, 0.f);
+        for (int p = S.ptr[r]; p < S.ptr[r + 1]; ++p)
+            A[S.col[p]] = S.val[p];
+    }
+}
+
+
+// rows [r0, r1) of C, one micro-panel of 16 columns (n of them in C), B is its packed K x 16 panel
+AVX2 void spmm_csr_16( const csr_t & S, int r0, int r1, const float * B, int n
+                     , float alpha, float beta, float * C, int ldc
+                     )
+{
+    const __m256i m0 = mask_8(n - 0);
+    const __m256i m1 = mask_8(n - 8);
+    const __m256  a  = _mm256_set1_ps(alpha);
+    const __m256  b  = _mm256_set1_ps(beta);
+
+    const int   * col = S.col.data();
+    const float * val = S.val.data();
+
+    for (int r = r0; r < r1; ++r)
+    {
+        __m256 c0 = _mm256_setzero_ps(), c1 = _mm256_setzero_ps(); // two chains per half: FMA latency
+        __m256 c2 = _mm256_setzero_ps(), c3 = _mm256_setzero_ps();
+
+        int p = S.ptr[r];
+        for (; p + 2 <= S.ptr[r + 1]; p += 2)
+        {
+            const float * b0 = B + col[p + 0] * 16, * b1 = B + col[p + 1] * 16;
+            const __m256 v0 = _mm256_set1_ps(val[p + 0]), v1 = _mm256_set1_ps(val[p + 1]);
+
+            c0 = _mm256_fmadd_ps(v0, _mm256_loadu_ps(b0 + 0), c0);
+            c1 = _mm256_fmadd_ps(v0, _mm256_loadu_ps(b0 + 8), c1);
+            c2 = _mm256_fmadd_ps(v1, _mm256_loadu_ps(b1 + 0), c2);
+            c3 = _mm256_fmadd_ps(v1, _mm256_loadu_ps(b1 + 8), c3);
+        }
+        if (p < S.ptr[r + 1])
+        {
+            const __m256 v = _mm256_set1_ps(val[p]);
+            c0 = _mm256_fmadd_ps(v, _mm256_loadu_ps(B + col[p] * 16 + 0), c0);
+            c1 = _mm256_fmadd_ps(v, _mm256_loadu_ps(B + col[p] * 16 + 8), c1);
+        }
+
+        float * pC = C + r * ldc;
+        c0 = _mm256_mul_ps(a, _mm256_add_ps(c0, c2));
+        c1 = _mm256_mul_ps(a, _mm256_add_ps(c1, c3));
+        if (beta != 0.f)
+        {
+            c0 = _mm256_fmadd_ps(b, _mm256_maskload_ps(pC + 0, m0), c0);
+            c1 = _mm256_fmadd_ps(b, _mm256_maskload_ps(pC + 8, m1), c1);
+        }
+        _mm256_maskstore_ps(pC + 0, m0, c0);
+        _mm256_maskstore_ps(pC + 8, m1, c1);
+    }
+}
+
+// row blocks [b0, b1) of C, as spmm_csr_16: 4 x 16 of C in registers, each panel row loaded once per block
+AVX2 void spmm_bcsr_16( const bcsr_t & S, int b0, int b1, const float * B, int n
+                      , float alpha, float beta, float * C, int ldc
+                      )
+{
+    constexpr int R = bcsr_t::R;
+    static_assert(R == 4, "4 rows of accumulators below");
+
+    const __m256i m0 = mask_8(n - 0);
+    const __m256i m1 = mask_8(n - 8);
+    const __m256  a  = _mm256_set1_ps(alpha);
+    const __m256  b  = _mm256_set1_ps(beta);
+
+    for (int q = b0; q < b1; ++q)
+    {
+        __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps(), c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+        __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps(), c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+
+        for (int p = S.ptr[q]; p < S.ptr[q + 1]; ++p)
+        {
+            const float * pB = B + S.col[p] * 16, * v = S.val.data() + p * R;
+            const __m256 x0 = _mm256_loadu_ps(pB + 0), x1 = _mm256_loadu_ps(pB + 8);
+            __m256 vi;
+
+            vi = _mm256_broadcast_ss(v + 0); c00 = _mm256_fmadd_ps(vi, x0, c00); c01 = _mm256_fmadd_ps(vi, x1, c01);
+            vi = _mm256_broadcast_ss(v + 1); c10 = _mm256_fmadd_ps(vi, x0, c10); c11 = _mm256_fmadd_ps(vi, x1, c11);
+            vi = _mm256_broadcast_ss(v + 2); c20 = _mm256_fmadd_ps(vi, x0, c20); c21 = _mm256_fmadd_ps(vi, x1, c21);
+            vi = _mm256_broadcast_ss(v + 3); c30 = _mm256_fmadd_ps(vi, x0, c30); c31 = _mm256_fmadd_ps(vi, x1, c31);
+        }
+
+        const __m256 c[R][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 }, { c30, c31 } }; // out of the loop: may live in memory
+
+        const int rows = std::min(R, S.M - q * R);
+        float * pC = C + q * R * ldc;
+        for (int i = 0; i < rows; ++i, pC += ldc)
+        {
+            __m256 d0 = _mm256_mul_ps(a, c[i][0]), d1 = _mm256_mul_ps(a, c[i][1]);
+            if (beta != 0.f)
+            {
+                d0 = _mm256_fmadd_ps(b, _mm256_maskload_ps(pC + 0, m0), d0);
+                d1 = _mm256_fmadd_ps(b, _mm256_maskload_ps(pC + 8, m1), d1);
+            }
+            _mm256_maskstore_ps(pC + 0, m0, d0);
+            _mm256_maskstore_ps(pC + 8, m1, d1);
+        }
+    }
+}
+
+// the portable paths of both: a row of R values per block, 1 for CSR
+void spmm_16_generic( const int * ptr, const int * col, const float * val, int R, int M, int q0, int q1
+                    , const float * B, int n, float alpha, float beta, float * C, int ldc
+                    )
+{
+    for (int q = q0; q < q1; ++q)
+    {
+        float c[bcsr_t::R][16] = {};
+        for (int p = ptr[q]; p < ptr[q + 1]; ++p)
+            for (int i = 0; i < R; ++i)
+                for (int j = 0; j < 16; ++j)
+                    c[i][j] += val[p * R + i] * B[col[p] * 16 + j];
+
+        for (int i = 0; i < std::min(R, M - q * R); ++i)
+            for (int j = 0; j < n; ++j)
+            {
+                float & x = C[(q * R + i) * ldc + j];
+                x = alpha * c[i][j] + (beta == 0.f ? 0.f : beta * x);
+            }
+    }
+}
+
+namespace detail
+{
+
+// q in [0, Q] splitting units [0, n) into T ranges of about equal weight ptr[u] + u:
+// the non-zeros, plus one per row for writing C
+std::vector<int> balance(const std::vector<int> & ptr, int n, int T)
+{
+    std::vector<int> q(T + 1, n);
+    q[0] = 0;
+
+    const long W = long(ptr[n]) + n;
+    for (int t = 1; t < T; ++t)
+    {
+        const long w = W * t / T;
+        int lo = q[t - 1], hi = n; // first u with ptr[u] + u >= w
+        while (lo < hi)
+        {
+            const int mid = (lo + hi) / 2;
+            if (long(ptr[mid]) + mid < w)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        q[t] = lo;
+    }
+    return q;
+}
+
+// op(B) (K x N) into 16-wide micro-panels, K * 16 floats apart, split over the pool
+buf_t pack_b_16(char transB, int K, int N, const float * B, int ldb, ThreadPool * pool)
+{
+    static const bool avx2 = find_kernel("avx2") != nullptr;
+
+    const int S = (N + 15) / 16;
+    buf_t bufB(std::max(1L, long(K) * S * 16));
+
+    const int T = tasks(pool, S, 4);
+    parallel_for(pool, T, [&](int t)
+    {
+        for (int s = S * t / T; s < S * (t + 1) / T; ++s)
+            (avx2 ? reorder_b : pack_b_generic<16>)(transB, K, std::min(16, N - s * 16), at(transB, B, ldb, 0, s * 16), ldb, bufB.p + long(K) * s * 16);
+    });
+    return bufB;
+}
+
+// the loop nest of both formats: units (rows or row blocks) split by non-zeros, then
+// the panels of B outer, so that a task sweeps its rows over one L2-sized panel at a time
+template<typename Sparse, typename Kernel>
+void spmm( const Sparse & S, int units, char transB, int N
+         , float alpha, const float * B, int ldb
+         , float beta ,       float * C, int ldc
+         , ThreadPool * pool, Kernel && kernel16
+         )
+{
+    if (S.M <= 0 || N <= 0)
+        return;
+
+    const buf_t bufB = pack_b_16(transB, S.K, N, B, ldb, pool);
+    const int T = pool ? std::max(1, std::min<int>(pool->size(), units)) : 1;
+    const std::vector<int> q = balance(S.ptr, units, T);
+
+    parallel_for(pool, T, [&](int t)
+    {
+        for (int j = 0; j < N; j += 16)
+            kernel16(q[t], q[t + 1], bufB.p + long(S.K) * j, std::min(16, N - j), C + j);
+    });
+}
+
+} // namespace detail
+
+void spmm( char transB, int N, float alpha, const csr_t & A
+         , const float * B, int ldb
+         , float beta, float * C, int ldc
+         , ThreadPool * pool = nullptr
+         )
+{
+    static const bool avx2 = find_kernel("avx2") != nullptr;
+
+    detail::spmm(A, A.M, transB, N, alpha, B, ldb, beta, C, ldc, pool, [&](int r0, int r1, const float * pB, int n, float * pC)
+    {
+        if (avx2)
+            spmm_csr_16(A, r0, r1, pB, n, alpha, beta, pC, ldc);
+        else
+            spmm_16_generic(A.ptr.data(), A.col.data(), A.val.data(), 1, A.M, r0, r1, pB, n, alpha, beta, pC, ldc);
+    });
+}
+
+void spmm( char transB, int N, float alpha, const bcsr_t & A
+         , const float * B, int ldb
+         , float beta, float * C, int ldc
+         , ThreadPool * pool = nullptr
+         )
+{
+    static const bool avx2 = find_kernel("avx2") != nullptr;
+
+    detail::spmm(A, int(A.ptr.size()) - 1, transB, N, alpha, B, ldb, beta, C, ldc, pool, [&](int b0, int b1, const float * pB, int n, float * pC)
+    {
+        if (avx2)
+            spmm_bcsr_16(A, b0, b1, pB, n, alpha, beta, pC, ldc);
+        else
+            spmm_16_generic(A.ptr.data(), A.col.data(), A.val.data(), bcsr_t::R, A.M, b0, b1, pB, n, alpha, beta, pC, ldc);
+    });
+}
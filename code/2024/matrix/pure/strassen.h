@@ -0,0 +1,196 @@
+#pragma once
+#include "../tools/matrix.h"
+#include "../tools/stats.h"
+#include <vector>
+
+// Strassen–Winograd: 7 half-size products and 15 additions per level instead of 8 products,
+// 1/8 of the flops saved per level; the error bound becomes normwise rather than elementwise
+// and grows with the number of levels, so only shapes from the cutoff up take a level,
+// the products below it go to the blocked sgemm
+
+// min(M, N, K) from which a level is taken: the profile's, or 4096
+int strassen_cutoff()
+{
+    return profile().strassen > 0 ? profile().strassen : 4096;
+}
+
+namespace detail
+{
+
+// Temporaries of one level are X (m x max(k, n), holds S and P1) and Y (k x n, holds T),
+// C itself holds the other products; the levels below take the arena after them
+long strassen_arena(int M, int N, int K, int cutoff)
+{
+    if (std::min({ M, N, K }) < cutoff)
+        return 0;
+
+    const int m = M / 2, n = N / 2, k = K / 2;
+    return long(m) * std::max(k, n) + long(k) * n + strassen_arena(m, n, k, cutoff);
+}
+
+// Z = X + s * Y, s = +-1
+void strassen_add(int M, int N, const float * X, int ldx, const float * Y, int ldy, float * Z, int ldz, float s)
+{
+    for (int i = 0; i < M; ++i, X += ldx, Y += ldy, Z += ldz)
+        for (int j = 0; j < N; ++j)
+            Z[j] = X[j] + s * Y[j];
+}
+
+struct strassen_t
+{
+    int cutoff;
+    ThreadPool * pool;
+
+    blocking_t blocking; // of the leaves, reused for the peeled edges
+    buf_t bufB;
+    std::vector<buf_t> bufA;
+
+    // C = A * B + beta * C on the blocked sgemm
+    void leaf(int M, int N, int K, const float * A, int lda, const float * B, int ldb, float beta, float * C, int ldc)
+    {
+        if (pool)
+            sgemm('N', 'N', M, N, K, 1.f, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA, *pool);
+        else
+            sgemm('N', 'N', M, N, K, 1.f, A, lda, B, ldb, beta, C, ldc, blocking, bufB, bufA[0]);
+    }
+};
+
+// C = A * B; the schedule of Boyer, Dumas, Pernet, Zhou (2009), two temporaries per level
+void strassen( strassen_t & s, int M, int N, int K
+             , const float * A, int lda
+             , const float * B, int ldb
+             ,       float * C, int ldc
+             , float * arena
+             )
+{
+    if (std::min({ M, N, K }) < s.cutoff)
+        return s.leaf(M, N, K, A, lda, B, ldb, 0.f, C, ldc);
+
+    const int m = M / 2, n = N / 2, k = K / 2; // even part, an odd last row / column is peeled below
+
+    const float * A11 = A, * A12 = A + k, * A21 = A + m * lda, * A22 = A21 + k;
+    const float * B11 = B, * B12 = B + n, * B21 = B + k * ldb, * B22 = B21 + n;
+    float       * C11 = C, * C12 = C + n, * C21 = C + m * ldc, * C22 = C21 + n;
+
+    const int ldx = std::max(k, n), ldy = n;
+    float * X    = arena;
+    float * Y    = X + long(m) * ldx;
+    float * next = Y + long(k) * ldy;
+
+    auto mul = [&](const float * P, int ldp, const float * Q, int ldq, float * R, int ldr)
+    {
+        strassen(s, m, n, k, P, ldp, Q, ldq, R, ldr, next);
+    };
+
+    strassen_add(m, k, A11, lda, A21, lda, X, ldx, -1.f); // S3 = A11 - A21
+    strassen_add(k, n, B22, ldb, B12, ldb, Y, ldy, -1.f); // T3 = B22 - B12
+    mul(X, ldx, Y, ldy, C21, ldc);                        // P7 = S3 T3
+    strassen_add(m, k, A21, lda, A22, lda, X, ldx, +1.f); // S1 = A21 + A22
+    strassen_add(k, n, B12, ldb, B11, ldb, Y, ldy, -1.f); // T1 = B12 - B11
+    mul(X, ldx, Y, ldy, C22, ldc);                        // P5 = S1 T1
+    strassen_add(m, k, X  , ldx, A11, lda, X, ldx, -1.f); // S2 = S1 - A11
+    strassen_add(k, n, B22, ldb, Y  , ldy, Y, ldy, -1.f); // T2 = B22 - T1
+    mul(X, ldx, Y, ldy, C12, ldc);                        // P6 = S2 T2
+    strassen_add(m, k, A12, lda, X  , ldx, X, ldx, -1.f); // S4 = A12 - S2
+    mul(X, ldx, B22, ldb, C11, ldc);                      // P3 = S4 B22
+    mul(A11, lda, B11, ldb, X, ldx);                      // P1 = A11 B11
+    strassen_add(m, n, X  , ldx, C12, ldc, C12, ldc, +1.f); // U2 = P1 + P6
+    strassen_add(m, n, C12, ldc, C21, ldc, C21, ldc, +1.f); // U3 = U2 + P7
+    strassen_add(m, n, C12, ldc, C22, ldc, C12, ldc, +1.f); // U4 = U2 + P5
+    strassen_add(m, n, C21, ldc, C22, ldc, C22, ldc, +1.f); // U7 = U3 + P5 = C22
+    strassen_add(m, n, C12, ldc, C11, ldc, C12, ldc, +1.f); // U5 = U4 + P3 = C12
+    strassen_add(k, n, Y  , ldy, B21, ldb, Y, ldy, -1.f);   // T4 = T2 - B21
+    mul(A22, lda, Y, ldy, C11, ldc);                        // P4 = A22 T4
+    strassen_add(m, n, C21, ldc, C11, ldc, C21, ldc, -1.f); // U6 = U3 - P4 = C21
+    mul(A12, lda, B21, ldb, C11, ldc);                      // P2 = A12 B21
+    strassen_add(m, n, X  , ldx, C11, ldc, C11, ldc, +1.f); // U1 = P1 + P2 = C11
+
+    if (K > 2 * k) // the last column of A times the last row of B
+        s.leaf(2 * m, 2 * n, 1, A + 2 * k, lda, B + 2 * k * ldb, ldb, 1.f, C, ldc);
+    if (N > 2 * n)
+        s.leaf(2 * m, 1, K, A, lda, B + 2 * n, ldb, 0.f, C + 2 * n, ldc);
+    if (M > 2 * m)
+        s.leaf(1, N, K, A + 2 * m * lda, lda, B, ldb, 0.f, C + 2 * m * ldc, ldc);
+}
+
+} // namespace detail
+
+// C = A * B (M x K times K x N, row-major) with Strassen–Winograd levels while min(M, N, K) >= cutoff;
+// one arena holds the temporaries of all levels, the leaves run on pool if given
+void sgemm_strassen( int M, int N, int K
+                   , const float * A, int lda
+                   , const float * B, int ldb
+                   ,       float * C, int ldc
+                   , ThreadPool * pool = nullptr
+                   , int cutoff = strassen_cutoff()
+                   )
+{
+    if (M <= 0 || N <= 0)
+        return;
+    if (K <= 0)
+        return kernel().init_c(M, N, C, ldc, 0.f);
+
+    cutoff = std::max(cutoff, 2);
+
+    int lM = M, lN = N, lK = K; // the leaves
+    while (std::min({ lM, lN, lK }) >= cutoff)
+        lM /= 2, lN /= 2, lK /= 2;
+
+    const blocking_t blocking = make_blocking(lM, lN, lK, pool ? pool->size() : 1);
+
+    detail::strassen_t s = { cutoff, pool, blocking, buf_t((pool ? 2 : 1) * bufB_size(blocking)), {} };
+    for (int t = 0; t < (pool ? blocking.tM * blocking.tN : 1); ++t)
+        s.bufA.emplace_back(bufA_size(blocking));
+
+    buf_t arena(std::max(1L, detail::strassen_arena(M, N, K, cutoff)));
+    detail::strassen(s, M, N, K, A, lda, B, ldb, C, ldc, arena.p);
+}
+
+void gemm_strassen( int M, int N, int K
+                  , const float * A
+                  , const float * B
+                  ,       float * C
+                  )
+{
+    sgemm_strassen(M, N, K, A, K, B, N, C, N);
+}
+
+Matrix<float> strassen(const Matrix<float> & A, const Matrix<float> & B, ThreadPool * pool = nullptr)
+{
+    assert(A.width == B.height);
+
+    Matrix<float> C = emptyMatrix<float>(B.width, A.height);
+    sgemm_strassen
+    (
+        A.height, B.width, A.width,
+        A.memory.get(), A.memoryWidth,
+        B.memory.get(), B.memoryWidth,
+        C.memory.get(), C.memoryWidth,
+        pool
+    );
+    return C;
+}
+
+// The smallest size at which one level beats the blocked sgemm, for the profile
+int autotune_strassen(unsigned int threads, std::ostream & log)
+{
+    ThreadPool pool(std::max(1u, threads));
+
+    for (int n : { 1024, 2048, 4096 })
+    {
+        buf_t A(n * n), B(n * n), C(n * n);
+        for (int i = 0; i < n * n; ++i)
+        {
+            A.p[i] = 1.f;
+            B.p[i] = 1.f;
+        }
+
+        const double tg = utils::stats<3u>([&] noexcept { sgemm('N', 'N', n, n, n, 1.f, A.p, n, B.p, n, 0.f, C.p, n, pool); }).first;
+        const double ts = utils::stats<3u>([&] noexcept { sgemm_strassen(n, n, n, A.p, n, B.p, n, C.p, n, &pool, n); }).first;
+
+        log << "# strassen " << n << ": " << ts * 1000. << " ms, sgemm " << tg * 1000. << " ms" << std::endl;
+        if (ts < tg)
+            return n;
+    }
+    return 8192;
+}
@@ -0,0 +1,248 @@
+#pragma once
+#include "../tools/threadpool.h"
+#include <vector>
+
+// SYRK and SYMM on the packers and micro-kernels of the sgemm. SYRK computes the tiles
+// of one triangle of C only (tiles on the diagonal through a local tile), about half the
+// FMAs of the full product; SYMM reads one triangle of the symmetric A, the other one is
+// packed from it with the transposed packer
+
+namespace detail
+{
+
+// cycles 6..4 of the serial sgemm with the packing and the block product given by the caller:
+// packB(k, j, dK, dN, buf) one micro-panel of B, packA(i, k, dM, dK, buf) a block of A,
+// block(i, dM, j, dN, dK, bufA, bufB) its product into C; blocks with skip(i, dM, j, dN) are left out.
+// The blocks of cycle 4 are split over the pool, and when there are fewer of them than workers
+// the micro-panels of B as well, as tM x tN in the parallel sgemm; each task packs into its own bufA.
+// With copies > 1 the packers store that many operands side by side: every micro-panel of B, and
+// every block of A, takes copies times its size (the blocking should be shrunk to match).
+// Each task's bufA is followed by `scratch` floats of its own, at buf + copies * bufA_size(blocking),
+// for a packA that gathers A before handing it to the kernel's packer
+template<typename PackA, typename PackB, typename Skip, typename Block>
+void blocked( const blocking_t & blocking, int M, int N, int K
+            , PackA && packA, PackB && packB, Skip && skip, Block && block
+            , ThreadPool * pool
+            , int copies = 1
+            , int scratch = 0
+            )
+{
+    const kernel_t & ker = *blocking.ker;
+    const int mK = blocking.mK, mM = blocking.mM, mN = blocking.mN, NR = ker.NR;
+
+    const int nI = (M + mM - 1) / mM;
+    const int P  = pool ? std::max(1u, pool->size()) : 1;
+    const int tN = std::min((P + nI - 1) / nI, (std::min(N, mN) + NR - 1) / NR); // chunks of micro-panels
+    const int T  = std::min(P, nI * tN);
+
+    buf_t bufB(copies * bufB_size(blocking));
+    std::vector<buf_t> bufA;
+    for (int t = 0; t < T; ++t)
+        bufA.emplace_back(copies * bufA_size(blocking) + scratch);
+
+    for (int j = 0; j < N; j += mN) // cycle 6
+    {
+        const int dN = std::min(N - j, mN);
+        const int nS = (dN + NR - 1) / NR;
+
+        for (int k = 0; k < K; k += mK) // cycle 5
+        {
+            const int dK = std::min(K - k, mK);
+
+            for (int s = 0; s < nS; ++s)
+                packB(k, j + s * NR, dK, std::min(NR, dN - s * NR), bufB.p + copies * dK * s * NR);
+
+            parallel_for(pool, T, [&](int t) // cycle 4, by (block of A, chunk of micro-panels)
+            {
+                for (int w = t; w < nI * tN; w += T)
+                {
+                    const int i  = w / tN * mM, dM = std::min(M - i, mM);
+                    const int s0 = nS * (w % tN) / tN, s1 = nS * (w % tN + 1) / tN;
+                    const int jc = j + s0 * NR, dC = std::min(dN, s1 * NR) - s0 * NR;
+                    if (dC <= 0 || skip(i, dM, jc, dC))
+                        continue;
+
+                    packA(i, k, dM, dK, bufA[t].p);
+                    block(i, dM, jc, dC, dK, bufA[t].p, bufB.p + copies * dK * s0 * NR);
+                }
+            });
+        }
+    }
+}
+
+// rows [r0, r0 + dR) x columns [c0, c0 + dC) of the symmetric S stored in one triangle of A,
+// cut along K (the columns for the A operand, byRow, the rows for the B operand) into the part
+// in the stored triangle, packed as is, the part in the other one, packed transposed, and the
+// few elements across the diagonal, packed from a copy; pack(trans, X, ldx, rows, cols, k) packs
+// one piece starting at offset k along K
+template<typename Pack>
+void pack_sym(bool lower, const float * A, int lda, int r0, int dR, int c0, int dC, bool byRow, Pack && pack)
+{
+    const int e0 = byRow ? c0 : r0, e1 = e0 + (byRow ? dC : dR);                            // K
+    const int m0 = std::clamp(byRow ? r0 : c0, e0, e1), m1 = std::clamp(m0 + (byRow ? dR : dC), e0, e1); // the diagonal
+
+    auto piece = [&](int k0, int k1, bool stored)
+    {
+        if (k0 >= k1)
+            return;
+        const int r = byRow ? r0 : k0, c = byRow ? k0 : c0;
+        pack(stored ? 'N' : 'T', stored ? A + r * lda + c : A + c * lda + r, lda,
+             byRow ? dR : k1 - k0, byRow ? k1 - k0 : dC, k0 - e0);
+    };
+
+    // before the diagonal along K, S is below it for the A operand, above it for the B operand
+    piece(e0, m0, byRow == lower);
+    piece(m1, e1, byRow != lower);
+
+    if (m0 >= m1)
+        return;
+
+    const int r = byRow ? r0 : m0, c = byRow ? m0 : c0;
+    const int R = byRow ? dR : m1 - m0, C = byRow ? m1 - m0 : dC;
+    std::vector<float> tmp(std::size_t(R) * C);
+
+    for (int p = 0; p < R; ++p)
+        for (int q = 0; q < C; ++q)
+        {
+            const int i = r + p, j = c + q;
+            tmp[p * C + q] = (i >= j) == lower ? A[i * lda + j] : A[j * lda + i];
+        }
+    pack('N', tmp.data(), C, R, C, m0 - e0);
+}
+
+} // namespace detail
+
+// Row-major BLAS ssyrk: C = alpha * A * A^T + beta * C (trans 'N', A is N x K) or
+// C = alpha * A^T * A + beta * C (trans 'T', A is K x N); only the 'L'ower or 'U'pper
+// triangle of the N x N C is read and written
+void ssyrk( char uplo, char trans, int N, int K
+          , float alpha, const float * A, int lda
+          , float beta ,       float * C, int ldc
+          , ThreadPool * pool = nullptr
+          )
+{
+    if (N <= 0)
+        return;
+
+    const kernel_t & ker = kernel();
+    const int  MR = ker.MR, NR = ker.NR;
+    const bool lower = uplo == 'L' || uplo == 'l';
+
+    for (int i = 0; i < N; ++i) // beta on the triangle
+        ker.init_c(1, lower ? i + 1 : N - i, C + i * ldc + (lower ? 0 : i), ldc, beta);
+    if (K <= 0 || alpha == 0.f)
+        return;
+
+    const char transA = is_trans(trans) ? 'T' : 'N'; // op(A) is N x K, the B operand is op(A)^T
+    const char transB = is_trans(trans) ? 'N' : 'T';
+
+    auto inside = [lower](int r, int dR, int c, int dC) { return lower ? c + dC - 1 <= r : c >= r + dR - 1; };
+    auto outside = [lower](int r, int dR, int c, int dC) { return lower ? c > r + dR - 1 : c + dC - 1 < r; };
+
+    detail::blocked
+    (
+        make_blocking(N, N, K, pool ? pool->size() : 1, ker), N, N, K,
+        [&](int i, int k, int dM, int dK, float * buf)
+        {
+            ker.pack_a(transA, at(transA, A, lda, i, k), lda, dM, dK, alpha, buf);
+        },
+        [&](int k, int j, int dK, int dN, float * buf)
+        {
+            ker.pack_b(transB, dK, dN, at(transB, A, lda, k, j), lda, buf);
+        },
+        outside,
+        [&](int i, int dM, int j, int dN, int dK, const float * bufA, const float * bufB)
+        {
+            for (int jj = 0; jj < dN; jj += NR) // cycles 3 and 2 over the tiles of the triangle
+                for (int ii = 0; ii < dM; ii += MR)
+                {
+                    const int r = i + ii, c = j + jj, dR = std::min(MR, dM - ii), dC = std::min(NR, dN - jj);
+                    const float * a = bufA + ii * dK, * b = bufB + jj * dK;
+                    float * pC = C + r * ldc + c;
+
+                    if (outside(r, dR, c, dC))
+                        continue;
+
+                    if (inside(r, dR, c, dC))
+                    {
+                        if (dR == MR && dC == NR)
+                            ker.micro(dK, a, b, pC, ldc);
+                        else
+                            ker.micro_tail(dR, dC, dK, a, b, pC, ldc);
+                        continue;
+                    }
+
+                    alignas(64) float tile[16 * 32] = {}; // across the diagonal: the tile's triangle only
+                    ker.micro(dK, a, b, tile, NR);
+                    for (int p = 0; p < dR; ++p)
+                        for (int q = 0; q < dC; ++q)
+                            if (lower ? c + q <= r + p : c + q >= r + p)
+                                pC[p * ldc + q] += tile[p * NR + q];
+                }
+        },
+        pool
+    );
+}
+
+// Row-major BLAS ssymm: C = alpha * A * B + beta * C (side 'L', A is M x M) or
+// C = alpha * B * A + beta * C (side 'R', A is N x N); A is symmetric and only its
+// 'L'ower or 'U'pper triangle is read, B and C are M x N
+void ssymm( char side, char uplo, int M, int N
+          , float alpha, const float * A, int lda
+          ,              const float * B, int ldb
+          , float beta ,       float * C, int ldc
+          , ThreadPool * pool = nullptr
+          )
+{
+    if (M <= 0 || N <= 0)
+        return;
+
+    const kernel_t & ker = kernel();
+    const bool left  = side == 'L' || side == 'l';
+    const bool lower = uplo == 'L' || uplo == 'l';
+    const int  K     = left ? M : N;
+
+    ker.init_c(M, N, C, ldc, beta);
+    if (alpha == 0.f)
+        return;
+
+    detail::blocked
+    (
+        make_blocking(M, N, K, pool ? pool->size() : 1, ker), M, N, K,
+        [&](int i, int k, int dM, int dK, float * buf)
+        {
+            if (!left)
+                return ker.pack_a('N', B + i * ldb + k, ldb, dM, dK, alpha, buf);
+
+            // a block of A is packed panel by panel, each one cut along K around the diagonal
+            for (int p = 0; p < dM; p += ker.MR)
+            {
+                const int dP = std::min(ker.MR, dM - p);
+                float * panel = buf + p * dK;
+
+                detail::pack_sym(lower, A, lda, i + p, dP, k, dK, true,
+                    [&](char t, const float * X, int ldx, int R, int Cn, int k0)
+                    {
+                        ker.pack_a(t, X, ldx, R, Cn, alpha, panel + k0 * ker.MR);
+                    });
+            }
+        },
+        [&](int k, int j, int dK, int dN, float * buf)
+        {
+            if (left)
+                return ker.pack_b('N', dK, dN, B + k * ldb + j, ldb, buf);
+
+            detail::pack_sym(lower, A, lda, k, dK, j, dN, false,
+                [&](char t, const float * X, int ldx, int R, int Cn, int k0)
+                {
+                    ker.pack_b(t, R, Cn, X, ldx, buf + k0 * ker.NR);
+                });
+        },
+        [](int, int, int, int) { return false; },
+        [&](int i, int dM, int j, int dN, int dK, const float * bufA, float * bufB)
+        {
+            macro(ker, dM, dN, dK, bufA, 'N', nullptr, 0, bufB, false, C + i * ldc + j, ldc);
+        },
+        pool
+    );
+}
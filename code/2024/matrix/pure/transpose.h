@@ -0,0 +1,292 @@
+#pragma once
+#include "../tools/matrix.h"
+#include "../tools/threadpool.h"
+#include <type_traits>
+
+// Transposes by recursive halving of the larger dimension down to 32 x 32 leaves, so that
+// every level of cache and the TLB see a block that fits them without knowing their sizes;
+// float leaves go through 8 x 8 register transposes. In place (square) the diagonal blocks
+// are transposed and the pairs across the diagonal are swapped transposed
+
+namespace detail
+{
+
+constexpr int transpose_leaf = 32;
+
+AVX2 void transpose_8x8_to(const float * A, long lda, float * B, long ldb) // B = A^T
+{
+    __m256 r[8];
+    for (int i = 0; i < 8; ++i)
+        r[i] = _mm256_loadu_ps(A + i * lda);
+    ::transpose_8x8(r);
+    for (int i = 0; i < 8; ++i)
+        _mm256_storeu_ps(B + i * ldb, r[i]);
+}
+
+AVX2 void swap_8x8(float * A1, float * A2, long lda) // A1 <- A2^T, A2 <- A1^T
+{
+    __m256 r[8], s[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        r[i] = _mm256_loadu_ps(A1 + i * lda);
+        s[i] = _mm256_loadu_ps(A2 + i * lda);
+    }
+    ::transpose_8x8(r);
+    ::transpose_8x8(s);
+    for (int i = 0; i < 8; ++i)
+    {
+        _mm256_storeu_ps(A1 + i * lda, s[i]);
+        _mm256_storeu_ps(A2 + i * lda, r[i]);
+    }
+}
+
+template<typename T>
+bool simd_transpose()
+{
+    if constexpr (std::is_same_v<T, float>)
+    {
+        static const bool avx2 = find_kernel("avx2") != nullptr;
+        return avx2;
+    }
+    else
+        return false;
+}
+
+// B (N x M) = A^T (A is M x N)
+template<typename T>
+void transpose_rec(int M, int N, const T * A, long lda, T * B, long ldb)
+{
+    constexpr int L = transpose_leaf;
+
+    if (M > L || N > L) // halve the larger side, on a multiple of 8
+    {
+        if (M >= N)
+        {
+            const int m = M / 16 * 8;
+            transpose_rec(m    , N, A           , lda, B    , ldb);
+            transpose_rec(M - m, N, A + m * lda , lda, B + m, ldb);
+        }
+        else
+        {
+            const int n = N / 16 * 8;
+            transpose_rec(M, n    , A    , lda, B           , ldb);
+            transpose_rec(M, N - n, A + n, lda, B + n * ldb , ldb);
+        }
+        return;
+    }
+
+    int m8 = 0, n8 = 0;
+    if (simd_transpose<T>())
+    {
+        m8 = M / 8 * 8, n8 = N / 8 * 8;
+        for (int j = 0; j < n8; j += 8) // along the rows of B: each line of it completed before the next
+            for (int i = 0; i < m8; i += 8)
+                transpose_8x8_to(reinterpret_cast<const float *>(A) + i * lda + j, lda, reinterpret_cast<float *>(B) + j * ldb + i, ldb);
+    }
+    for (int i = 0; i < M; ++i) // the edges, or all of it
+        for (int j = i < m8 ? n8 : 0; j < N; ++j)
+            B[j * ldb + i] = A[i * lda + j];
+}
+
+// A1 (M x N) <- A2^T, A2 (N x M) <- A1^T, disjoint blocks of one matrix
+template<typename T>
+void swap_rec(int M, int N, T * A1, T * A2, long lda)
+{
+    constexpr int L = transpose_leaf;
+
+    if (M > L || N > L)
+    {
+        if (M >= N)
+        {
+            const int m = M / 16 * 8;
+            swap_rec(m    , N, A1          , A2    , lda);
+            swap_rec(M - m, N, A1 + m * lda, A2 + m, lda);
+        }
+        else
+        {
+            const int n = N / 16 * 8;
+            swap_rec(M, n    , A1    , A2          , lda);
+            swap_rec(M, N - n, A1 + n, A2 + n * lda, lda);
+        }
+        return;
+    }
+
+    int m8 = 0, n8 = 0;
+    if (simd_transpose<T>())
+    {
+        m8 = M / 8 * 8, n8 = N / 8 * 8;
+        for (int i = 0; i < m8; i += 8)
+            for (int j = 0; j < n8; j += 8)
+                swap_8x8(reinterpret_cast<float *>(A1) + i * lda + j, reinterpret_cast<float *>(A2) + j * lda + i, lda);
+    }
+    for (int i = 0; i < M; ++i)
+        for (int j = i < m8 ? n8 : 0; j < N; ++j)
+            std::swap(A1[i * lda + j], A2[j * lda + i]);
+}
+
+// A (N x N) <- A^T
+template<typename T>
+void transpose_diag_rec(int N, T * A, long lda)
+{
+    if (N > transpose_leaf)
+    {
+        const int n = N / 16 * 8;
+        transpose_diag_rec(n    , A               , lda);
+        transpose_diag_rec(N - n, A + n * lda + n , lda);
+        swap_rec(n, N - n, A + n, A + n * lda, lda);
+        return;
+    }
+
+    int n8 = 0;
+    if (simd_transpose<T>())
+    {
+        n8 = N / 8 * 8;
+        for (int i = 0; i < n8; i += 8)
+        {
+            float * d = reinterpret_cast<float *>(A) + i * lda + i;
+            transpose_8x8_to(d, lda, d, lda);
+            for (int j = i + 8; j < n8; j += 8)
+                swap_8x8(reinterpret_cast<float *>(A) + i * lda + j, reinterpret_cast<float *>(A) + j * lda + i, lda);
+        }
+    }
+    for (int i = 0; i < N; ++i)
+        for (int j = std::max(i + 1, i < n8 ? n8 : 0); j < N; ++j)
+            std::swap(A[i * lda + j], A[j * lda + i]);
+}
+
+} // namespace detail
+
+// B (N x M) = A^T, A is M x N; the larger side is split over the pool
+template<typename T>
+void transpose(int M, int N, const T * A, long lda, T * B, long ldb, ThreadPool * pool = nullptr)
+{
+    const bool rows = M >= N;
+    const int  n    = rows ? M : N;
+    const int  nT   = detail::tasks(pool, n / 8, 8);
+
+    detail::parallel_for(pool, nT, [&](int t)
+    {
+        const int a = n / 8 * t / nT * 8, b = t + 1 == nT ? n : n / 8 * (t + 1) / nT * 8;
+        if (rows)
+            detail::transpose_rec(b - a, N, A + a * lda, lda, B + a, ldb);
+        else
+            detail::transpose_rec(M, b - a, A + a, lda, B + a * ldb, ldb);
+    });
+}
+
+// A (N x N) = A^T in place; the pairs of G x G bands go to the pool
+template<typename T>
+void transpose_inplace(int N, T * A, long lda, ThreadPool * pool = nullptr)
+{
+    const int G = detail::tasks(pool, N / 8, 16);
+    auto band = [&](int g) { return g == G ? N : N / 8 * g / G * 8; };
+
+    const int pairs = G * (G + 1) / 2;
+    const int nT    = pool ? std::min<int>(pool->size(), pairs) : 1;
+
+    detail::parallel_for(pool, nT, [&](int t)
+    {
+        for (int w = 0, p = 0; p < G; ++p)
+            for (int q = p; q < G; ++q, ++w)
+            {
+                if (w % nT != t)
+                    continue;
+
+                const int i0 = band(p), i1 = band(p + 1), j0 = band(q), j1 = band(q + 1);
+                if (p == q)
+                    detail::transpose_diag_rec(i1 - i0, A + i0 * lda + i0, lda);
+                else
+                    detail::swap_rec(i1 - i0, j1 - j0, A + i0 * lda + j0, A + j0 * lda + i0, lda);
+            }
+    });
+}
+
+// Matrix<T> is row-major: its transpose is also the conversion to and from column-major
+template<typename T>
+Matrix<T> transpose(const Matrix<T> & A, ThreadPool * pool = nullptr)
+{
+    Matrix<T> B = emptyMatrix<T>(A.height, A.width, 64);
+    transpose(int(A.height), int(A.width), A.memory.get(), long(A.memoryWidth), B.memory.get(), long(B.memoryWidth), pool);
+    return B;
+}
+
+template<typename T>
+void transpose_inplace(Matrix<T> & A, ThreadPool * pool = nullptr)
+{
+    assert(A.width == A.height);
+    transpose_inplace(int(A.width), A.memory.get(), long(A.memoryWidth), pool);
+}
+
+// Panel-packed layout, as the packers make it: rows, panels of `panel` rows, each column by column
+// (bufA of the micro-kernels); otherwise panels of `panel` columns, each row by row (bufB).
+// The last panel is zero-padded. A column-major matrix is the row-major transpose, so its
+// row panels are the column panels of that transpose and the other way around
+template<typename T>
+struct panels_t
+{
+    std::unique_ptr<T[], FreeDeleter> memory;
+    std::size_t width, height, panel;
+    bool rows;
+
+    std::size_t count() const { return ((rows ? height : width) + panel - 1) / panel; }
+    std::size_t depth() const { return rows ? width : height; } // the other side: the length of a panel
+    T       * operator[](std::size_t p)       noexcept { assert(p < count()); return memory.get() + p * panel * depth(); }
+    T const * operator[](std::size_t p) const noexcept { assert(p < count()); return memory.get() + p * panel * depth(); }
+};
+
+template<typename T>
+panels_t<T> to_panels(const Matrix<T> & A, std::size_t panel, bool rows, ThreadPool * pool = nullptr)
+{
+    panels_t<T> P = { {}, A.width, A.height, panel, rows };
+    const std::size_t size = P.count() * panel * P.depth();
+    P.memory.reset(static_cast<T *>(std::aligned_alloc(64, (size * sizeof(T) + 63) / 64 * 64)));
+
+    const int n = int(P.count());
+    const int nT = detail::tasks(pool, n, 1);
+    detail::parallel_for(pool, nT, [&](int t)
+    {
+        for (int p = n * t / nT; p < n * (t + 1) / nT; ++p)
+        {
+            T * dst = P[p];
+            const std::size_t e0 = p * panel, e = std::min(panel, (rows ? A.height : A.width) - e0); // rows / columns in it
+
+            if (rows) // panel x width, column by column: the transpose of the slab
+            {
+                transpose(int(e), int(A.width), A[e0], long(A.memoryWidth), dst, long(panel));
+                for (std::size_t c = 0; c < A.width; ++c)
+                    std::fill(dst + c * panel + e, dst + (c + 1) * panel, T(0));
+            }
+            else      // height x panel, row by row
+                for (std::size_t r = 0; r < A.height; ++r)
+                {
+                    std::copy_n(A[r] + e0, e, dst + r * panel);
+                    std::fill(dst + r * panel + e, dst + (r + 1) * panel, T(0));
+                }
+        }
+    });
+    return P;
+}
+
+template<typename T>
+Matrix<T> from_panels(const panels_t<T> & P, ThreadPool * pool = nullptr)
+{
+    Matrix<T> A = emptyMatrix<T>(P.width, P.height, 64);
+
+    const int n = int(P.count());
+    const int nT = detail::tasks(pool, n, 1);
+    detail::parallel_for(pool, nT, [&](int t)
+    {
+        for (int p = n * t / nT; p < n * (t + 1) / nT; ++p)
+        {
+            const T * src = P[p];
+            const std::size_t e0 = p * P.panel, e = std::min(P.panel, (P.rows ? P.height : P.width) - e0);
+
+            if (P.rows)
+                transpose(int(P.width), int(e), src, long(P.panel), A[e0], long(A.memoryWidth));
+            else
+                for (std::size_t r = 0; r < P.height; ++r)
+                    std::copy_n(src + r * P.panel, e, A[r] + e0);
+        }
+    });
+    return A;
+}
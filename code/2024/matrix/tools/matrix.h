@@ -3,18 +3,24 @@
 #include <memory>
 #include <algorithm>
 
+// named rather than a lambda type, so Matrix can be used from headers
+struct FreeDeleter
+{
+    void operator()(void * const p) const noexcept {std::free(p);}
+};
+
 template<typename T>
 struct Matrix
 {
-    std::unique_ptr
-    <
-        T[],
-        decltype([](void * const p) noexcept {std::free(p);})
-    > memory;
+    std::unique_ptr<T[], FreeDeleter> memory;
     std::size_t memoryWidth, width, height;
 
     T       *operator[](std::size_t const rowI)       noexcept {assert(rowI < height); return memory.get() + rowI * memoryWidth;}
     T const *operator[](std::size_t const rowI) const noexcept {assert(rowI < height); return memory.get() + rowI * memoryWidth;}
+
+    // a lazy expression (pure/expr.h) is evaluated into the matrix on assignment
+    template<typename E> requires requires(E && e, Matrix & m) {std::move(e).assign_to(m);}
+    Matrix &operator=(E &&e) {std::move(e).assign_to(*this); return *this;}
 };
 
 template<typename T>
@@ -1,3 +1,4 @@
+#pragma once
 #include <experimental/simd>
 #include "types.h"
 
@@ -8,3 +9,9 @@ using ABI = stdx::simd_abi::fixed_size<N>;
 
 template<std::size_t N>
 using vf32t = stdx::simd<f32, ABI<N>>;
+
+template<std::size_t N>
+using vf64t = stdx::simd<f64, ABI<N>>;
+
+template<typename T, std::size_t N>
+using vt = stdx::simd<T, ABI<N>>;
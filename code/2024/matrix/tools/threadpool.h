@@ -1,3 +1,4 @@
+#pragma once
 #include <condition_variable>
 #include <execution>
 #include <thread>
@@ -90,6 +91,8 @@ public:
         return res;
     }
 
+    unsigned int size() const noexcept { return slaves.size(); }
+
     void wait()
     {
         std::unique_lock<std::mutex> lock(completedTaskMtx);